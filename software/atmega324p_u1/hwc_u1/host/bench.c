@@ -0,0 +1,214 @@
+// Throughput of the Modbus ASCII receiver on the host
+// usage: bench [-t seconds] [file ...]
+//   file: recorded frames, one frame per line, '#' starts a comment line
+//   without file only synthetic frames are used
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "global.h"
+#include "sys.h"
+#include "sys_host.h"
+#include "modbus.h"
+#include "modbus_ascii.h"
+#include "modbus_rtu.h"
+#include "app.h"
+
+#define BENCH_SYNTHETIC_FRAMES  512
+
+struct Bench_Frames {
+    const char *name;
+    char     *data;      // all frames including CR LF
+    uint32_t size;
+    uint32_t capacity;
+    uint32_t frames;
+};
+
+struct Bench_Result {
+    uint64_t frames;
+    uint64_t bytes;
+    uint64_t txBytes;
+    double   seconds;
+};
+
+static double bench_seconds = 1.0;
+
+static double bench_now () {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1E-9;
+}
+
+static void bench_append (struct Bench_Frames *f, const char *s, uint32_t length) {
+    if (f->size + length > f->capacity) {
+        f->capacity = (f->size + length) * 2;
+        f->data = realloc(f->data, f->capacity);
+        if (f->data == NULL) {
+            fprintf(stderr, "out of memory\n");
+            exit(1);
+        }
+    }
+    memcpy(f->data + f->size, s, length);
+    f->size += length;
+}
+
+static void bench_appendFrame (struct Bench_Frames *f, const uint8_t b[], uint8_t length, uint8_t lrcError) {
+    char s[3 + GLOBAL_MODBUS_ASCII_BUFSIZE * 2 + 2];
+    uint8_t lrc = 0;
+    int n = sprintf(s, ":");
+    for (uint8_t i = 0; i < length; i++) {
+        lrc += b[i];
+        n += sprintf(s + n, "%02X", b[i]);
+    }
+    lrc = (uint8_t)(-lrc) + (lrcError ? 1 : 0);
+    n += sprintf(s + n, "%02X\r\n", lrc);
+    bench_append(f, s, n);
+    f->frames++;
+}
+
+static int bench_loadRecorded (struct Bench_Frames *f, const char *fileName) {
+    FILE *fp = fopen(fileName, "r");
+    if (fp == NULL) {
+        perror(fileName);
+        return 1;
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        size_t n = strcspn(line, "\r\n");
+        if (n == 0 || line[0] == '#') {
+            continue;
+        }
+        bench_append(f, line, n);
+        bench_append(f, "\r\n", 2);
+        f->frames++;
+    }
+    fclose(fp);
+    f->name = fileName;
+    return 0;
+}
+
+// register reads/writes like the server sends them, some with LRC error or invalid characters
+static void bench_createSynthetic (struct Bench_Frames *f) {
+    uint32_t seed = 1;
+    f->name = "synthetic";
+    for (int i = 0; i < BENCH_SYNTHETIC_FRAMES; i++) {
+        seed = seed * 1103515245 + 12345;
+        uint8_t r = seed >> 16;
+        uint16_t value = seed >> 8;
+        uint8_t quantity = 1 + (r % 5);
+        switch (r % 4) {
+            case 0: {
+                uint8_t b[] = { GLOBAL_MODBUS_DEVICEADDR, 0x03, 0, 0, 0, quantity };
+                bench_appendFrame(f, b, sizeof(b), 0);
+                break;
+            }
+            case 1: {
+                uint8_t b[] = { GLOBAL_MODBUS_DEVICEADDR, 0x06, 0, 0, value >> 8, value & 0xff };
+                bench_appendFrame(f, b, sizeof(b), 0);
+                break;
+            }
+            case 2: {
+                uint8_t b[] = { GLOBAL_MODBUS_DEVICEADDR, 0x17, 0, 0, 0, quantity, 0, 0, 0, 1, 2, value >> 8, value & 0xff };
+                bench_appendFrame(f, b, sizeof(b), (r & 0x0f) == 2);
+                break;
+            }
+            case 3: {
+                uint8_t b[] = { GLOBAL_MODBUS_DEVICEADDR, 0x03, 0x10, 0, 0, 0x0c };
+                bench_appendFrame(f, b, sizeof(b), 0);
+                if ((r & 0x1f) == 3) {
+                    bench_append(f, ":01G3\r\n", 7);
+                    f->frames++;
+                }
+                break;
+            }
+        }
+    }
+}
+
+static void bench_reset () {
+    sysHost_init();
+    modbusAscii_init();
+    modbusRtu_init();
+    modbus_init();
+    app_init();
+}
+
+// handleRequest == 0: only modbusAscii_handleModbusAsciiByte(), received frames are discarded
+// handleRequest != 0: each frame is handled by modbusAscii_main() (request and response)
+static void bench_run (const struct Bench_Frames *f, uint8_t handleRequest, struct Bench_Result *result) {
+    memset(result, 0, sizeof(*result));
+    bench_reset();
+    double start = bench_now();
+    double end = start;
+    while ((end - start) < bench_seconds) {
+        for (int loop = 0; loop < 64; loop++) {
+            const char *p = f->data;
+            for (uint32_t i = 0; i < f->size; i++) {
+                char c = *p++;
+                modbusAscii_handleModbusAsciiByte(c);
+                if (c == '\n') {
+                    if (handleRequest) {
+                        modbusAscii_main();
+                    } else {
+                        modbus_ascii.length[0] = 0;
+                        modbus_ascii.length[1] = 0;
+                    }
+                }
+            }
+        }
+        result->frames += (uint64_t)f->frames * 64;
+        result->bytes += (uint64_t)f->size * 64;
+        end = bench_now();
+    }
+    fflush(sys.fOutModbus);
+    result->seconds = end - start;
+    result->txBytes = sys_host.txBytes;
+}
+
+static void bench_print (const struct Bench_Frames *f, const char *mode, const struct Bench_Result *r) {
+    printf("%-24s %-8s %12.0f frames/s %14.0f bytes/s %8.2f ns/byte %14.0f tx bytes/s\n",
+           f->name, mode, r->frames / r->seconds, r->bytes / r->seconds, r->seconds * 1E9 / r->bytes,
+           r->txBytes / r->seconds);
+}
+
+static void bench_frames (const struct Bench_Frames *f) {
+    struct Bench_Result r;
+    if (f->frames == 0) {
+        fprintf(stderr, "%s: no frames\n", f->name);
+        return;
+    }
+    bench_run(f, 0, &r);
+    bench_print(f, "decode", &r);
+    bench_run(f, 1, &r);
+    bench_print(f, "request", &r);
+    if (modbus_ascii.err.lrcError > 0 || modbus_ascii.err.invalidUartByte > 0 || modbus_ascii.err.invalidFrame > 0) {
+        printf("%-24s errors: lrc=%u invalidUartByte=%u invalidFrame=%u overflow=%u busy=%u\n", "",
+               modbus_ascii.err.lrcError, modbus_ascii.err.invalidUartByte, modbus_ascii.err.invalidFrame,
+               modbus_ascii.err.frameOverflow, modbus_ascii.err.byteWhileBusy);
+    }
+}
+
+int main (int argc, char *argv[]) {
+    int i = 1;
+    if (argc > 2 && strcmp(argv[1], "-t") == 0) {
+        bench_seconds = atof(argv[2]);
+        i = 3;
+    }
+
+    struct Bench_Frames synthetic = { 0 };
+    bench_createSynthetic(&synthetic);
+    bench_frames(&synthetic);
+    free(synthetic.data);
+
+    for (; i < argc; i++) {
+        struct Bench_Frames recorded = { 0 };
+        if (bench_loadRecorded(&recorded, argv[i]) == 0) {
+            bench_frames(&recorded);
+        }
+        free(recorded.data);
+    }
+    return 0;
+}
@@ -0,0 +1,63 @@
+// libFuzzer entry point for the Modbus ASCII receiver
+// every input byte is passed to modbusAscii_handleModbusAsciiByte(), received frames are
+// handled by modbusAscii_main() like in the main loop of the firmware
+// FUZZ_STANDALONE: main() runs the inputs given as files (reproduce crashes without clang)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "global.h"
+#include "sys.h"
+#include "sys_host.h"
+#include "modbus.h"
+#include "modbus_ascii.h"
+#include "modbus_rtu.h"
+#include "app.h"
+
+static void fuzz_check () {
+    if (modbus_ascii.bIndex > GLOBAL_MODBUS_ASCII_BUFSIZE ||
+        modbus_ascii.length[0] > GLOBAL_MODBUS_ASCII_BUFSIZE || modbus_ascii.length[1] > GLOBAL_MODBUS_ASCII_BUFSIZE ||
+        modbus_ascii.rxBuffer > 1 || modbus_ascii.mainBuffer > 1 || modbus.rxMode > MODBUS_MODE_RTU) {
+        abort();
+    }
+}
+
+int LLVMFuzzerTestOneInput (const uint8_t *data, size_t size) {
+    sysHost_init();
+    modbusAscii_init();
+    modbusRtu_init();
+    modbus_init();
+    app_init();
+    for (size_t i = 0; i < size; i++) {
+        modbusAscii_handleModbusAsciiByte((char)data[i]);
+        fuzz_check();
+        if (data[i] == '\n') {
+            modbusAscii_main();
+            fuzz_check();
+        }
+    }
+    modbusAscii_main();
+    modbusAscii_main();
+    fuzz_check();
+    return 0;
+}
+
+#ifdef FUZZ_STANDALONE
+int main (int argc, char *argv[]) {
+    static uint8_t data[0x10000];
+    for (int i = 1; i < argc; i++) {
+        FILE *fp = fopen(argv[i], "rb");
+        if (fp == NULL) {
+            perror(argv[i]);
+            return 1;
+        }
+        size_t size = fread(data, 1, sizeof(data), fp);
+        fclose(fp);
+        LLVMFuzzerTestOneInput(data, size);
+        printf("%s: %zu bytes ok\n", argv[i], size);
+    }
+    return 0;
+}
+#endif
@@ -0,0 +1,15 @@
+// host build: EEPROM variables are plain SRAM variables
+
+#ifndef HOST_AVR_EEPROM_H_
+#define HOST_AVR_EEPROM_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#define EEMEM
+#define eeprom_read_block(dst, src, n)  memcpy((dst), (src), (n))
+#define eeprom_update_word(p, value)    (*(uint16_t *)(p) = (value))
+#define eeprom_update_byte(p, value)    (*(uint8_t *)(p) = (value))
+#define eeprom_is_ready()               1
+
+#endif // HOST_AVR_EEPROM_H_
@@ -0,0 +1,10 @@
+// host build: no interrupt system, ISRs are called directly
+
+#ifndef HOST_AVR_INTERRUPT_H_
+#define HOST_AVR_INTERRUPT_H_
+
+#define sei()
+#define cli()
+#define ISR(vector) void vector (void)
+
+#endif // HOST_AVR_INTERRUPT_H_
@@ -0,0 +1,19 @@
+// host build: I/O registers are plain variables defined in sys_host.c
+
+#ifndef HOST_AVR_IO_H_
+#define HOST_AVR_IO_H_
+
+#include <stdint.h>
+
+extern volatile uint8_t  PORTA, PORTB, PORTC, PORTD, PINA, PINB, PINC, PIND, DDRA, DDRB, DDRC, DDRD;
+extern volatile uint8_t  TCCR0A, TCCR0B, TCNT0, OCR0A, OCR0B, TIMSK0, TIFR0;
+extern volatile uint8_t  TCCR1A, TCCR1B, TCCR1C, TIMSK1, TIFR1;
+extern volatile uint16_t TCNT1, OCR1A, OCR1B, ICR1;
+extern volatile uint8_t  TCCR2A, TCCR2B, TCNT2, OCR2A, OCR2B, TIMSK2, TIFR2;
+extern volatile uint8_t  ADMUX, ADCSRA, ADCSRB, ADCL, ADCH, DIDR0;
+extern volatile uint16_t ADC;
+extern volatile uint8_t  UCSR0A, UCSR0B, UCSR0C, UBRR0L, UBRR0H, UDR0;
+extern volatile uint8_t  UCSR1A, UCSR1B, UCSR1C, UBRR1L, UBRR1H, UDR1;
+extern volatile uint8_t  SREG, GPIOR0, GPIOR1, GPIOR2;
+
+#endif // HOST_AVR_IO_H_
@@ -0,0 +1,16 @@
+// host build: flash and SRAM share one address space
+
+#ifndef HOST_AVR_PGMSPACE_H_
+#define HOST_AVR_PGMSPACE_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define PSTR(s) (s)
+#define pgm_read_byte(p) (*(const uint8_t *)(p))
+#define pgm_read_word(p) (*(const uint16_t *)(p))
+#define pgm_read_ptr(p)  (*(void * const *)(p))
+#define memcpy_P(dst, src, n) memcpy((dst), (src), (n))
+
+#endif // HOST_AVR_PGMSPACE_H_
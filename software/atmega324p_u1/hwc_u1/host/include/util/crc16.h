@@ -0,0 +1,20 @@
+// host build: C version of avr-libc _crc16_update() (polynomial 0xa001, Modbus CRC)
+
+#ifndef HOST_UTIL_CRC16_H_
+#define HOST_UTIL_CRC16_H_
+
+#include <stdint.h>
+
+static inline uint16_t _crc16_update (uint16_t crc, uint8_t a) {
+    crc ^= a;
+    for (uint8_t i = 0; i < 8; i++) {
+        if (crc & 1) {
+            crc = (crc >> 1) ^ 0xa001;
+        } else {
+            crc = (crc >> 1);
+        }
+    }
+    return crc;
+}
+
+#endif // HOST_UTIL_CRC16_H_
@@ -0,0 +1,79 @@
+// decoder for the binary log of the firmware on UART0 (see ../src/log.h)
+// reads the raw UART0 bytes from the files given as arguments (or stdin) and prints
+// text unchanged and each record as one line: uptime, log site and data
+// usage: stty -F /dev/ttyUSB1 115200 raw && dist/log_decode < /dev/ttyUSB1
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "log.h"
+
+struct LogDecode_Site {
+    const char *name;
+    uint8_t format;
+    const char *text;
+};
+
+#define LOG_DECODE_ENTRY(id, name, format, text) [id] = { #name, format, text },
+
+static const struct LogDecode_Site logDecode_site[256] = {
+    LOG_TABLE(LOG_DECODE_ENTRY)
+};
+
+static void logDecode_record (uint8_t header[], uint8_t data[]) {
+    const struct LogDecode_Site *s = &logDecode_site[header[1]];
+    uint8_t length = header[2];
+    uint16_t t = header[3] | header[4] << 8;
+    printf("\n[%5u.%03u] ", t / 1000, t % 1000);
+    if (s->name == NULL) {
+        printf("unknown log site %u:", header[1]);
+    } else {
+        printf("%s:", s->text);
+    }
+    if (s->name != NULL && s->format == LOG_FORMAT_U16) {
+        for (uint8_t i = 0; i + 1 < length; i += 2) {
+            printf(" %u", data[i] | data[i + 1] << 8);
+        }
+    } else {
+        for (uint8_t i = 0; i < length; i++) {
+            printf(" %02X", data[i]);
+        }
+    }
+    printf("\n");
+}
+
+static void logDecode_file (FILE *f) {
+    uint8_t header[LOG_HEADER_SIZE];
+    uint8_t data[256];
+    int c;
+    while ((c = fgetc(f)) != EOF) {
+        if (c != LOG_SYNC) {
+            putchar(c); // text (printf)
+            continue;
+        }
+        header[0] = c;
+        if (fread(&header[1], 1, LOG_HEADER_SIZE - 1, f) != LOG_HEADER_SIZE - 1 || fread(data, 1, header[2], f) != header[2]) {
+            printf("\n(incomplete record)\n");
+            break;
+        }
+        logDecode_record(header, data);
+        fflush(stdout);
+    }
+}
+
+int main (int argc, char *argv[]) {
+    if (argc < 2) {
+        logDecode_file(stdin);
+        return 0;
+    }
+    for (int i = 1; i < argc; i++) {
+        FILE *f = fopen(argv[i], "rb");
+        if (f == NULL) {
+            fprintf(stderr, "%s: cannot open file\n", argv[i]);
+            return 1;
+        }
+        logDecode_file(f);
+        fclose(f);
+    }
+    return 0;
+}
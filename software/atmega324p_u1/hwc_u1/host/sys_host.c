@@ -0,0 +1,209 @@
+// host build: replaces sys.c, the hardware is reduced to variables
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "global.h"
+#include "sys.h"
+#include "sys_host.h"
+
+volatile uint8_t  PORTA, PORTB, PORTC, PORTD, PINA, PINB, PINC, PIND, DDRA, DDRB, DDRC, DDRD;
+volatile uint8_t  TCCR0A, TCCR0B, TCNT0, OCR0A, OCR0B, TIMSK0, TIFR0;
+volatile uint8_t  TCCR1A, TCCR1B, TCCR1C, TIMSK1, TIFR1;
+volatile uint16_t TCNT1, OCR1A, OCR1B, ICR1;
+volatile uint8_t  TCCR2A, TCCR2B, TCNT2, OCR2A, OCR2B, TIMSK2, TIFR2;
+volatile uint8_t  ADMUX, ADCSRA, ADCSRB, ADCL, ADCH, DIDR0;
+volatile uint16_t ADC;
+volatile uint8_t  UCSR0A, UCSR0B, UCSR0C, UBRR0L, UBRR0H, UDR0;
+volatile uint8_t  UCSR1A, UCSR1B, UCSR1C, UBRR1L, UBRR1H, UDR1;
+volatile uint8_t  SREG, GPIOR0, GPIOR1, GPIOR2;
+
+struct Sys sys;
+struct Sys_TaskTimes sys_taskTimes;
+struct SysHost sys_host;
+
+static ssize_t sysHost_writeModbus (void *cookie, const char *buf, size_t size) {
+    sys_host.txBytes += size;
+    return size;
+}
+
+void sysHost_init () {
+    static cookie_io_functions_t fOutModbus = { NULL, sysHost_writeModbus, NULL, NULL };
+    memset((void *)&sys_host, 0, sizeof(sys_host));
+    if (sys.fOutModbus == NULL) {
+        sys.fOutModbus = fopencookie(NULL, "w", fOutModbus);
+        setvbuf(sys.fOutModbus, NULL, _IOFBF, 1024);
+    }
+    FILE *f = sys.fOutModbus;
+    memset((void *)&sys, 0, sizeof(sys));
+    sys.version = 1;
+    sys.fOutModbus = f;
+}
+
+void sys_init () {
+    sysHost_init();
+}
+
+void sys_main () {
+}
+
+void sys_inc8BitCnt (uint8_t *count) {
+    if (*count < 0xff) {
+        (*count)++;
+    }
+}
+
+void sys_inc16BitCnt (uint16_t *count) {
+    if (*count < 0xffff) {
+        (*count)++;
+    }
+}
+
+void sys_newline () {
+}
+
+uint8_t sys_uart0_available () {
+    return 0;
+}
+
+int16_t sys_uart0_getBufferByte (uint8_t pos) {
+    return -1;
+}
+
+void sys_uart0_flush () {
+}
+
+uint8_t sys_isUart1TxComplete () {
+    return 1;
+}
+
+uint8_t sys_getUart1TxFree () {
+    return 0xff;
+}
+
+void sys_waitUart1TxFree (uint8_t free) {
+}
+
+void sys_setUart1Bitrate (uint32_t bitrate) {
+    sys_host.uart1Bitrate = bitrate;
+}
+
+void sys_startUart1Timeout (uint16_t ticks) {
+}
+
+uint16_t sys_getAdcRaw () {
+    return sys.adc.ch[SYS_ADC_CH_4TO20MA].raw;
+}
+
+uint16_t sys_getAdcValue () {
+    return sys.adc.ch[SYS_ADC_CH_4TO20MA].value;
+}
+
+uint16_t sys_getAdcChannel (uint8_t channel) {
+    return channel < SYS_ADC_CHANNELS ? sys.adc.ch[channel].filtered : 0;
+}
+
+uint16_t sys_getAdcFiltered () {
+    return sys.adc.ch[SYS_ADC_CH_4TO20MA].filtered;
+}
+
+uint16_t sys_getAdcAt () {
+    return sys.adc.ch[SYS_ADC_CH_4TO20MA].at;
+}
+
+uint16_t sys_getAdcChannelAt (uint8_t channel) {
+    return channel < SYS_ADC_CHANNELS ? sys.adc.ch[channel].at : 0;
+}
+
+uint16_t sys_getAdcFilterShift () {
+    return sys.adc.filterShift;
+}
+
+uint8_t sys_setAdcFilterShift (uint16_t shift) {
+    if (shift > 8) {
+        return 1;
+    }
+    sys.adc.filterShift = shift;
+    return 0;
+}
+
+uint32_t sys_getTimestamp () {
+    return sys_host.timestamp;
+}
+
+void sys_log (uint8_t id, const uint8_t *data, uint8_t length) {
+    sys_host.logRecords++;
+}
+
+uint32_t sys_getUptimeMs () {
+    return sys_host.uptimeMs;
+}
+
+uint16_t sys_getTaskTimer () {
+    return TCNT1;
+}
+
+void sys_updateTaskTime (uint8_t slot, uint16_t start) {
+}
+
+int8_t sys_addTask (void (*run)(void), uint16_t period, uint8_t phase, uint16_t budgetUs) {
+    return sys_host.tasks < SYS_TASKS ? sys_host.tasks++ : -1;
+}
+
+void sys_clearTaskTimes () {
+    memset((void *)&sys_taskTimes, 0, sizeof(sys_taskTimes));
+    sys_taskTimes.version = 1;
+    sys_taskTimes.slots = SYS_TASKTIME_SLOTS;
+}
+
+uint16_t sys_getOvercurrentLevel () {
+    return sys.overcurrent.level;
+}
+
+void sys_setOvercurrentLevel (uint16_t level) {
+    sys.overcurrent.level = level;
+}
+
+uint8_t sys_isOvercurrentFault () {
+    return sys.overcurrent.fault;
+}
+
+void sys_clearOvercurrentFault () {
+    sys.overcurrent.fault = 0;
+}
+
+void sys_setSSR (uint8_t index, uint8_t on) {}
+void sys_setSSR1 (uint8_t on) {}
+void sys_setSSR2 (uint8_t on) {}
+void sys_setSSR3 (uint8_t on) {}
+void sys_setSSR4 (uint8_t on) {}
+
+uint8_t sys_isSw2On () {
+    return sys_host.sw2;
+}
+
+uint8_t sys_isSensor1On () {
+    return sys_host.sensor1;
+}
+
+uint8_t sys_isSensor2On () {
+    return sys_host.sensor2;
+}
+
+void sys_setPwm4To20mA (uint8_t value) {
+    OCR2A = sys.overcurrent.fault ? 0 : value;
+}
+
+void sys_setLedLife (uint8_t on) {}
+void sys_setLedPwmGreen (uint8_t on) {}
+void sys_setLedPT1000Red (uint8_t index, uint8_t on) {}
+void sys_setLedPT1000Green (uint8_t index, uint8_t on) {}
+void sys_setLedSensor (uint8_t index, uint8_t on) {}
+void sys_setLedSensor1 (uint8_t on) {}
+void sys_setLedSensor2 (uint8_t on) {}
+
+void sys_toggleLifeLed () {}
+void sys_toggleLedPwmGreen () {}
@@ -0,0 +1,22 @@
+#ifndef SYS_HOST_H_
+#define SYS_HOST_H_
+
+#include <stdint.h>
+
+struct SysHost {
+    uint64_t txBytes;    // bytes written to sys.fOutModbus
+    uint8_t  sw2;        // value returned by sys_isSw2On()
+    uint8_t  sensor1;    // value returned by sys_isSensor1On()
+    uint8_t  sensor2;    // value returned by sys_isSensor2On()
+    uint32_t timestamp;  // value returned by sys_getTimestamp()
+    uint32_t uptimeMs;   // value returned by sys_getUptimeMs()
+    uint32_t logRecords; // calls of sys_log()
+    uint32_t uart1Bitrate; // last value of sys_setUart1Bitrate()
+    uint8_t  tasks;      // calls of sys_addTask()
+};
+
+extern struct SysHost sys_host;
+
+void sysHost_init ();
+
+#endif // SYS_HOST_H_
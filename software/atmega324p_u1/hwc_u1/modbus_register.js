@@ -0,0 +1,132 @@
+// Generates the holding register table for the firmware (src/modbus_register.h)
+// and the register decoder for the server (hwc-register.ts) from modbus_register.json
+// usage: node modbus_register.js
+
+const fs = require('fs');
+const path = require('path');
+
+const descriptorFile = path.join(__dirname, 'modbus_register.json');
+const cFile = path.join(__dirname, 'src', 'modbus_register.h');
+const tsFile = path.join(__dirname, '..', '..', 'rpi', 'hwc-server-ngx', 'server', 'src', 'modbus', 'hwc-register.ts');
+
+const header = 'generated by modbus_register.js from modbus_register.json, do not edit';
+
+function load () {
+    const d = JSON.parse(fs.readFileSync(descriptorFile, 'utf8'));
+    const used = [];
+    let size = 0;
+    for (const r of d.registers) {
+        r.words = r.words || 1;
+        r.scale = r.scale || 1;
+        r.signed = r.signed || false;
+        r.get = Array.isArray(r.get) ? r.get : [ r.get ];
+        r.set = Array.isArray(r.set) ? r.set : (r.set ? [ r.set ] : []);
+        if (!(r.addr >= 0 && r.addr < 0x400) || !/^[a-z][A-Za-z0-9]*$/.test(r.name)) {
+            throw new Error('invalid register ' + JSON.stringify(r));
+        }
+        if (r.words < 1 || r.words > 2 || r.get.length !== r.words || (r.set.length > 0 && r.set.length !== r.words)) {
+            throw new Error('invalid get/set for register ' + r.name);
+        }
+        for (let i = 0; i < r.words; i++) {
+            if (used[r.addr + i]) {
+                throw new Error('register ' + r.name + ' overlaps ' + used[r.addr + i]);
+            }
+            used[r.addr + i] = r.name;
+        }
+        size = Math.max(size, r.addr + r.words);
+    }
+    d.size = size;
+    return d;
+}
+
+function pad (s, n) {
+    while (s.length < n) { s += ' '; }
+    return s;
+}
+
+function createC (d) {
+    const l = [];
+    l.push('// ' + header);
+    l.push('');
+    l.push('#ifndef MODBUS_REGISTER_H_');
+    l.push('#define MODBUS_REGISTER_H_');
+    l.push('');
+    for (const r of d.registers) {
+        l.push(pad('#define MODBUS_REGISTER_' + r.name.toUpperCase(), 50) + r.addr + ' // ' + r.comment);
+    }
+    l.push(pad('#define MODBUS_REGISTER_SIZE', 50) + d.size);
+    l.push('');
+    l.push('// R(addr, get, set) for each register word, set is NULL for read only registers');
+    l.push('#define MODBUS_REGISTER_TABLE(R) \\');
+    for (const r of d.registers) {
+        for (let i = 0; i < r.words; i++) {
+            l.push('    R(' + (r.addr + i) + ', ' + r.get[i] + ', ' + (r.set.length > 0 ? r.set[i] : 'NULL') + ') \\');
+        }
+    }
+    l.push('    // end of MODBUS_REGISTER_TABLE');
+    l.push('');
+    l.push('#endif // MODBUS_REGISTER_H_');
+    l.push('');
+    return l.join('\n');
+}
+
+function createTs (d) {
+    const l = [];
+    l.push('// ' + header);
+    l.push('');
+    l.push('export interface IHwcRegisterValues {');
+    for (const r of d.registers) {
+        l.push('    ' + pad(r.name + ': number;', 30) + '// ' + (r.unit ? '[' + r.unit + '] ' : '') + r.comment);
+    }
+    l.push('}');
+    l.push('');
+    l.push('export interface IHwcRegister {');
+    l.push('    addr: number;   // protocol address (0-based)');
+    l.push('    words: number;');
+    l.push('    scale: number;');
+    l.push('    unit: string;');
+    l.push('}');
+    l.push('');
+    l.push('export class HwcRegister {');
+    l.push('');
+    for (const r of d.registers) {
+        l.push('    public static readonly ' + r.name + ': IHwcRegister = { addr: ' + r.addr + ', words: ' + r.words +
+               ', scale: ' + r.scale + ', unit: ' + (r.unit ? '\'' + r.unit + '\'' : 'null') + ' };');
+    }
+    l.push('    public static readonly size = ' + d.size + ';');
+    l.push('');
+    l.push('    public static createValues (): IHwcRegisterValues {');
+    l.push('        return {');
+    l.push(d.registers.map( (r) => '            ' + r.name + ': Number.NaN').join(',\n'));
+    l.push('        };');
+    l.push('    }');
+    l.push('');
+    l.push('    // decodes quantity register words (starting with protocol address addr) from buffer[offset...] into values');
+    l.push('    // values are divided by scale, invalid values are decoded as NaN');
+    l.push('    // registers not completely covered by the block are not modified');
+    l.push('    public static decode (values: IHwcRegisterValues, buffer: Buffer, offset: number, addr: number, quantity: number) {');
+    l.push('        const end = addr + quantity;');
+    for (const r of d.registers) {
+        const read = (r.signed ? 'readInt' : 'readUInt') + (r.words === 1 ? '16BE' : '32BE');
+        const v = 'buffer.' + read + '(offset + (' + r.addr + ' - addr) * 2)';
+        l.push('        if (addr <= ' + r.addr + ' && end >= ' + (r.addr + r.words) + ') {');
+        if (r.invalid !== undefined) {
+            l.push('            const v = ' + v + ';');
+            l.push('            values.' + r.name + ' = v === ' + r.invalid + ' ? Number.NaN : ' + (r.scale !== 1 ? 'v / ' + r.scale : 'v') + ';');
+        } else {
+            l.push('            values.' + r.name + ' = ' + (r.scale !== 1 ? v + ' / ' + r.scale : v) + ';');
+        }
+        l.push('        }');
+    }
+    l.push('    }');
+    l.push('');
+    l.push('}');
+    l.push('');
+    return l.join('\n');
+}
+
+const descriptor = load();
+fs.writeFileSync(cFile, createC(descriptor));
+console.log('file ' + cFile + ' created');
+fs.writeFileSync(tsFile, createTs(descriptor));
+console.log('file ' + tsFile + ' created');
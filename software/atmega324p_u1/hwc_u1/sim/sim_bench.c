@@ -0,0 +1,391 @@
+// Cycle accurate benchmark of dist/atmega324p_u1.elf running in simavr
+// usage: sim_bench [-rtu] [-n loops] elf-file symbol-file frame-file
+//   symbol-file: output of avr-nm for elf-file
+//   frame-file:  Modbus ASCII frames, one per line, '#' starts comment line (see ../host/frames)
+//   -rtu:        frames are converted and sent as Modbus RTU frames
+// reports latency (interrupt pending -> vector entered) and duration of USART1_RX_vect and
+// TIMER0_COMPA_vect, execution cycles of the tasks and request -> response turnaround
+// function cycles include nested interrupts, turnaround expects GLOBAL_MODBUS_ECHOREQUEST=1
+// (the response starts after the echo of the request)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "sim_avr.h"
+#include "sim_elf.h"
+#include "sim_irq.h"
+#include "sim_interrupts.h"
+#include "avr_uart.h"
+
+#define SIM_F_CPU                   12000000UL
+#define SIM_VECT_TIMER0_COMPA       16  // vector numbers of ATmega324P
+#define SIM_VECT_USART1_RX          28
+#define SIM_MAX_NESTING             8
+#define SIM_MAX_FRAME               128
+#define SIM_RESPONSE_IDLE_CYCLES    (SIM_F_CPU / 500)   // 2ms without byte -> response complete
+#define SIM_RESPONSE_TIMEOUT_CYCLES (SIM_F_CPU / 10)    // 100ms
+#define SIM_REQUEST_GAP_CYCLES      (SIM_F_CPU / 1000)  // 1ms between response and next request
+#define SIM_STARTUP_CYCLES          (SIM_F_CPU / 20)    // 50ms
+
+struct Sim_Samples {
+    const char *name;
+    uint32_t *value;
+    uint32_t size;
+    uint32_t capacity;
+};
+
+struct Sim_Vector {
+    uint8_t  vector;
+    uint8_t  depth;
+    avr_cycle_count_t pendingAt;
+    avr_cycle_count_t runningAt[SIM_MAX_NESTING];
+    struct Sim_Samples latency;
+    struct Sim_Samples duration;
+};
+
+struct Sim_Function {
+    const char *name;
+    uint32_t addr;
+    struct Sim_Samples cycles;
+};
+
+struct Sim_Call {
+    struct Sim_Function *function;
+    uint16_t sp;
+    avr_cycle_count_t startAt;
+};
+
+struct Sim_Frame {
+    uint8_t data[SIM_MAX_FRAME];
+    uint8_t length;
+};
+
+struct Sim {
+    avr_t *avr;
+    struct Sim_Vector vectors[2];
+    struct Sim_Function functions[12];
+    uint8_t functionCnt;
+    struct Sim_Call calls[SIM_MAX_NESTING];
+    uint8_t callDepth;
+    uint32_t sysAddr;
+    uint32_t rxCnt;              // USART1_RX interrupts since start of request
+    uint32_t txCnt;              // bytes written to UDR1 since start of request
+    avr_cycle_count_t requestEndAt;
+    avr_cycle_count_t responseStartAt;
+    avr_cycle_count_t lastTxAt;
+    uint8_t  requestLength;      // bytes on the wire, echo has the same length
+    struct Sim_Samples turnaroundFirst;
+    struct Sim_Samples turnaroundComplete;
+    uint32_t requests;
+    uint32_t timeouts;
+};
+
+static struct Sim sim;
+
+static const char *sim_functionNames[] = {
+    "app_task_1ms", "app_task_2ms", "app_task_4ms", "app_task_8ms", "app_task_16ms", "app_task_32ms",
+    "app_task_64ms", "app_task_128ms", "app_main", "modbusAscii_main", "modbusRtu_main", NULL
+};
+
+static void sim_addSample (struct Sim_Samples *s, uint32_t value) {
+    if (s->size >= s->capacity) {
+        s->capacity = s->capacity == 0 ? 1024 : s->capacity * 2;
+        s->value = realloc(s->value, s->capacity * sizeof(uint32_t));
+        if (s->value == NULL) {
+            fprintf(stderr, "out of memory\n");
+            exit(1);
+        }
+    }
+    s->value[s->size++] = value;
+}
+
+static int sim_compare (const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+static uint32_t sim_percentile (const struct Sim_Samples *s, uint32_t permille) {
+    uint32_t i = (uint64_t)(s->size - 1) * permille / 1000;
+    return s->value[i];
+}
+
+static void sim_printHeader (const char *title) {
+    printf("\n%-28s %8s %8s %8s %8s %8s %8s %10s\n", title, "samples", "min", "p50", "p99", "p99.9", "max", "avg");
+}
+
+static void sim_printSamples (const char *name, struct Sim_Samples *s) {
+    if (s->size == 0) {
+        printf("%-28s %8u\n", name, 0);
+        return;
+    }
+    uint64_t sum = 0;
+    qsort(s->value, s->size, sizeof(uint32_t), sim_compare);
+    for (uint32_t i = 0; i < s->size; i++) {
+        sum += s->value[i];
+    }
+    printf("%-28s %8u %8u %8u %8u %8u %8u %10.1f\n", name, s->size, s->value[0], sim_percentile(s, 500),
+           sim_percentile(s, 990), sim_percentile(s, 999), s->value[s->size - 1], (double)sum / s->size);
+}
+
+static uint16_t sim_sp () {
+    return sim.avr->data[R_SPL] | (sim.avr->data[R_SPH] << 8);
+}
+
+static void sim_onPending (struct avr_irq_t *irq, uint32_t value, void *param) {
+    struct Sim_Vector *v = param;
+    if (value) {
+        v->pendingAt = sim.avr->cycle;
+        if (v->vector == SIM_VECT_USART1_RX && ++sim.rxCnt == sim.requestLength) {
+            sim.requestEndAt = sim.avr->cycle;
+        }
+    }
+}
+
+static void sim_onRunning (struct avr_irq_t *irq, uint32_t value, void *param) {
+    struct Sim_Vector *v = param;
+    if (value) {
+        sim_addSample(&v->latency, sim.avr->cycle - v->pendingAt);
+        if (v->depth < SIM_MAX_NESTING) {
+            v->runningAt[v->depth] = sim.avr->cycle;
+        }
+        v->depth++;
+    } else if (v->depth > 0) {
+        v->depth--;
+        if (v->depth < SIM_MAX_NESTING) {
+            sim_addSample(&v->duration, sim.avr->cycle - v->runningAt[v->depth]);
+        }
+    }
+}
+
+static void sim_onUart1Output (struct avr_irq_t *irq, uint32_t value, void *param) {
+    sim.txCnt++;
+    sim.lastTxAt = sim.avr->cycle;
+    if (sim.txCnt == sim.requestLength + 1) { // first byte after echo
+        sim.responseStartAt = sim.avr->cycle;
+    }
+}
+
+// executes one instruction and tracks entry and return of the functions in sim.functions
+static int sim_step () {
+    int state = avr_run(sim.avr);
+    uint16_t sp = sim_sp();
+    while (sim.callDepth > 0 && sp > sim.calls[sim.callDepth - 1].sp) {
+        struct Sim_Call *c = &sim.calls[--sim.callDepth];
+        sim_addSample(&c->function->cycles, sim.avr->cycle - c->startAt);
+    }
+    avr_flashaddr_t pc = sim.avr->pc;
+    for (uint8_t i = 0; i < sim.functionCnt; i++) {
+        if (sim.functions[i].addr == pc && sim.callDepth < SIM_MAX_NESTING) {
+            struct Sim_Call *c = &sim.calls[sim.callDepth++];
+            c->function = &sim.functions[i];
+            c->sp = sp;
+            c->startAt = sim.avr->cycle;
+        }
+    }
+    return state;
+}
+
+static int sim_runUntil (avr_cycle_count_t cycle) {
+    while (sim.avr->cycle < cycle) {
+        int state = sim_step();
+        if (state == cpu_Done || state == cpu_Crashed) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int sim_loadSymbols (const char *fileName) {
+    FILE *fp = fopen(fileName, "r");
+    if (fp == NULL) {
+        perror(fileName);
+        return 1;
+    }
+    char line[256], type, name[128];
+    unsigned int addr;
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        if (sscanf(line, "%x %c %127s", &addr, &type, name) != 3) {
+            continue;
+        }
+        if (strcmp(name, "sys") == 0) {
+            sim.sysAddr = addr & 0xffff; // data addresses are 0x800000 + SRAM address
+        }
+        for (uint8_t i = 0; sim_functionNames[i] != NULL; i++) {
+            if ((type == 'T' || type == 't') && strcmp(name, sim_functionNames[i]) == 0 && sim.functionCnt < 12) {
+                struct Sim_Function *f = &sim.functions[sim.functionCnt++];
+                f->name = sim_functionNames[i];
+                f->addr = addr;
+            }
+        }
+    }
+    fclose(fp);
+    return 0;
+}
+
+static uint8_t sim_hex2nibble (char c) {
+    return c <= '9' ? c - '0' : c - 'A' + 10;
+}
+
+static int sim_loadFrames (const char *fileName, uint8_t rtu, struct Sim_Frame frames[], int max) {
+    FILE *fp = fopen(fileName, "r");
+    if (fp == NULL) {
+        perror(fileName);
+        return -1;
+    }
+    char line[256];
+    int n = 0;
+    while (n < max && fgets(line, sizeof(line), fp) != NULL) {
+        size_t length = strcspn(line, "\r\n");
+        if (length < 5 || line[0] != ':' || length + 2 > SIM_MAX_FRAME) {
+            continue;
+        }
+        struct Sim_Frame *f = &frames[n++];
+        if (!rtu) {
+            memcpy(f->data, line, length);
+            f->data[length++] = '\r';
+            f->data[length++] = '\n';
+            f->length = length;
+        } else {
+            uint16_t crc = 0xffff;
+            f->length = 0;
+            for (size_t i = 1; i + 3 < length; i += 2) { // without LRC
+                uint8_t b = (sim_hex2nibble(line[i]) << 4) | sim_hex2nibble(line[i + 1]);
+                f->data[f->length++] = b;
+                crc ^= b;
+                for (uint8_t j = 0; j < 8; j++) {
+                    crc = (crc & 1) ? (crc >> 1) ^ 0xa001 : crc >> 1;
+                }
+            }
+            f->data[f->length++] = crc & 0xff;
+            f->data[f->length++] = crc >> 8;
+        }
+    }
+    fclose(fp);
+    return n;
+}
+
+static void sim_disableStdio (char uart) {
+    uint32_t flags = 0;
+    avr_ioctl(sim.avr, AVR_IOCTL_UART_GET_FLAGS(uart), &flags);
+    flags &= ~AVR_UART_FLAG_STDIO;
+    avr_ioctl(sim.avr, AVR_IOCTL_UART_SET_FLAGS(uart), &flags);
+}
+
+static int sim_request (const struct Sim_Frame *f, avr_irq_t *uart1Input) {
+    sim.rxCnt = 0;
+    sim.txCnt = 0;
+    sim.requestEndAt = 0;
+    sim.responseStartAt = 0;
+    sim.requestLength = f->length;
+    avr_cycle_count_t start = sim.avr->cycle;
+    for (uint8_t i = 0; i < f->length; i++) {
+        avr_raise_irq(uart1Input, f->data[i]);
+    }
+    while (1) {
+        if (sim_runUntil(sim.avr->cycle + 100)) {
+            return 1;
+        }
+        if (sim.responseStartAt > 0 && (sim.avr->cycle - sim.lastTxAt) > SIM_RESPONSE_IDLE_CYCLES) {
+            sim_addSample(&sim.turnaroundFirst, sim.responseStartAt - sim.requestEndAt);
+            sim_addSample(&sim.turnaroundComplete, sim.lastTxAt - sim.requestEndAt);
+            break;
+        }
+        if ((sim.avr->cycle - start) > SIM_RESPONSE_TIMEOUT_CYCLES) {
+            sim.timeouts++;
+            break;
+        }
+    }
+    sim.requests++;
+    return sim_runUntil(sim.avr->cycle + SIM_REQUEST_GAP_CYCLES);
+}
+
+int main (int argc, char *argv[]) {
+    static struct Sim_Frame frames[256];
+    uint8_t rtu = 0;
+    int loops = 20;
+    int i = 1;
+    for (; i < argc && argv[i][0] == '-'; i++) {
+        if (strcmp(argv[i], "-rtu") == 0) {
+            rtu = 1;
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            loops = atoi(argv[++i]);
+        }
+    }
+    if (argc - i != 3) {
+        fprintf(stderr, "usage: sim_bench [-rtu] [-n loops] elf-file symbol-file frame-file\n");
+        return 1;
+    }
+    const char *elfFile = argv[i], *symFile = argv[i + 1], *frameFile = argv[i + 2];
+
+    memset(&sim, 0, sizeof(sim));
+    int frameCnt = sim_loadFrames(frameFile, rtu, frames, 256);
+    if (frameCnt <= 0 || sim_loadSymbols(symFile)) {
+        fprintf(stderr, "cannot load frames/symbols\n");
+        return 1;
+    }
+
+    elf_firmware_t fw;
+    memset(&fw, 0, sizeof(fw));
+    if (elf_read_firmware(elfFile, &fw)) {
+        fprintf(stderr, "cannot read %s\n", elfFile);
+        return 1;
+    }
+    sim.avr = avr_make_mcu_by_name("atmega324p");
+    if (sim.avr == NULL) {
+        fprintf(stderr, "simavr does not support atmega324p\n");
+        return 1;
+    }
+    avr_init(sim.avr);
+    avr_load_firmware(sim.avr, &fw);
+    sim.avr->frequency = SIM_F_CPU;
+    sim_disableStdio('0');
+    sim_disableStdio('1');
+
+    sim.vectors[0].vector = SIM_VECT_USART1_RX;
+    sim.vectors[0].latency.name = "USART1_RX_vect";
+    sim.vectors[1].vector = SIM_VECT_TIMER0_COMPA;
+    sim.vectors[1].latency.name = "TIMER0_COMPA_vect";
+    for (int v = 0; v < 2; v++) {
+        avr_irq_t *irq = avr_get_interrupt_irq(sim.avr, sim.vectors[v].vector);
+        avr_irq_register_notify(irq + AVR_INT_IRQ_PENDING, sim_onPending, &sim.vectors[v]);
+        avr_irq_register_notify(irq + AVR_INT_IRQ_RUNNING, sim_onRunning, &sim.vectors[v]);
+    }
+    avr_irq_register_notify(avr_io_getirq(sim.avr, AVR_IOCTL_UART_GETIRQ('1'), UART_IRQ_OUTPUT), sim_onUart1Output, NULL);
+    avr_irq_t *uart1Input = avr_io_getirq(sim.avr, AVR_IOCTL_UART_GETIRQ('1'), UART_IRQ_INPUT);
+
+    int crashed = sim_runUntil(SIM_STARTUP_CYCLES);
+    for (int l = 0; l < loops && !crashed; l++) {
+        for (int f = 0; f < frameCnt && !crashed; f++) {
+            crashed = sim_request(&frames[f], uart1Input);
+        }
+    }
+
+    printf("%s, %s frames from %s, %u requests, %u without response, %.3f s simulated\n",
+           elfFile, rtu ? "RTU" : "ASCII", frameFile, sim.requests, sim.timeouts, (double)sim.avr->cycle / SIM_F_CPU);
+    if (crashed) {
+        printf("ERROR: simulation stopped at pc=0x%04x cycle=%llu\n", sim.avr->pc, (unsigned long long)sim.avr->cycle);
+    }
+    sim_printHeader("interrupt latency [cycles]");
+    for (int v = 0; v < 2; v++) {
+        sim_printSamples(sim.vectors[v].latency.name, &sim.vectors[v].latency);
+    }
+    sim_printHeader("interrupt duration [cycles]");
+    for (int v = 0; v < 2; v++) {
+        sim_printSamples(sim.vectors[v].latency.name, &sim.vectors[v].duration);
+    }
+    sim_printHeader("function duration [cycles]");
+    for (uint8_t f = 0; f < sim.functionCnt; f++) {
+        sim_printSamples(sim.functions[f].name, &sim.functions[f].cycles);
+    }
+    sim_printHeader("turnaround [cycles]");
+    sim_printSamples("request end -> response", &sim.turnaroundFirst);
+    sim_printSamples("request end -> response end", &sim.turnaroundComplete);
+    if (sim.sysAddr > 0) {
+        // struct Sys: version, debugLevel, err.taskErr_u16
+        uint16_t taskErr = sim.avr->data[sim.sysAddr + 2] | (sim.avr->data[sim.sysAddr + 3] << 8);
+        printf("\nsys.err.taskErr_u16 = %u\n", taskErr);
+    }
+    return crashed ? 2 : 0;
+}
@@ -1,28 +1,88 @@
 #include "global.h"
 #include <stdio.h>
 #include <string.h>
+#include <stddef.h>
 
 #include <avr/io.h>
 #include <avr/interrupt.h>
+#include <avr/eeprom.h>
+#include <avr/pgmspace.h>
 #include <util/delay.h>
 
 #include "app.h"
 #include "sys.h"
+#include "pt1000.h"
 
 // defines
 #define test 0
 
+#define APP_S0_TICKS_PER_MS            (SYS_TIMESTAMP_FREQ / 1000)
+#define APP_S0_SENSOR0TIME_TICKS       (2 * APP_S0_TICKS_PER_MS)  // unit of app.sensor0Time
+#define APP_S0_SENSOR0TIME_TIMEOUT_MS  10000
+// power [0.1W] = pulses * APP_S0_POWER_NUM / (ticks >> 8)
+#define APP_S0_POWER_NUM               ((uint32_t)(3600000ULL * 10 * SYS_TIMESTAMP_FREQ / 256 / GLOBAL_S0_PULSES_PER_KWH))
+
+#if (3600000ULL * 10 * (F_CPU / 8) / 256 / GLOBAL_S0_PULSES_PER_KWH) * (GLOBAL_S0_PULSES - 1) > 0xffffffffULL
+  #error "Error: GLOBAL_S0_PULSES_PER_KWH too small for 32 bit power calculation"
+#endif
+#if (GLOBAL_S0_PULSES & (GLOBAL_S0_PULSES - 1)) != 0 || GLOBAL_S0_PULSES > 128
+  #error "Error: GLOBAL_S0_PULSES must be a power of 2 (max. 128)"
+#endif
+
+#define APP_POWER_TABLE_MAGIC          0x5054
+
 // declarations and definations
 
 struct App app;
 
+// power at 6..20mA, measured with the 2kW heater
+static const uint16_t app_powerTableDefault[APP_POWER_TABLE_SIZE] PROGMEM = {
+    3, 6, 26, 48, 122, 257, 460, 716, 1045, 1292, 1553, 1730, 1870, 1935, 1950
+};
+
+static struct App_PowerTable app_eePowerTable EEMEM;
+
+static struct App_Sample app_samples[GLOBAL_SAMPLE_FIFO_SIZE];
+
+#if (GLOBAL_SAMPLE_FIFO_SIZE & (GLOBAL_SAMPLE_FIFO_SIZE - 1)) != 0 || GLOBAL_SAMPLE_FIFO_SIZE > 128
+  #error "Error: GLOBAL_SAMPLE_FIFO_SIZE must be a power of 2 (max. 128)"
+#endif
+
 
 // functions
 
+static void app_addTask (void (*run)(void), uint16_t period, uint8_t phase, uint16_t budgetUs) {
+    if (sys_addTask(run, period, phase, budgetUs) < 0) {
+        printf("\r\nERROR: task (period %u, phase %u) not registered", period, phase);
+    }
+}
+
 void app_init (void) {
     memset((void *)&app, 0, sizeof(app));
     app.version = 1;
     app.sensor0Time = 0xffff;
+    app.pi.mode = GLOBAL_4TO20MA_CONTROL;
+    app.power.setpoint = APP_POWER_INACTIVE;
+    app.power.slewUp = GLOBAL_POWER_SLEW_UP;
+    app.power.slewDown = GLOBAL_POWER_SLEW_DOWN;
+    eeprom_read_block(&app.power.table, &app_eePowerTable, sizeof(app.power.table));
+    if (app.power.table.magic != APP_POWER_TABLE_MAGIC) {
+        memcpy_P(app.power.table.watts, app_powerTableDefault, sizeof(app.power.table.watts));
+    }
+    app.pt1000Temp[0] = PT1000_INVALID;
+    app.pt1000Temp[1] = PT1000_INVALID;
+    app_setOvercurrentTrip(GLOBAL_OVERCURRENT_TRIP);
+
+    // period and phase in 500us ticks, different phases -> never two of them in the same tick
+    // budget [us] is the worst case execution time, longer executions are counted as overrun
+    app_addTask(app_task_1ms,     2,   1, 150);
+    app_addTask(app_task_2ms,     4,   2,  50);
+    app_addTask(app_task_4ms,     8,   4,  20);
+    app_addTask(app_task_8ms,    16,   8,  20);
+    app_addTask(app_task_16ms,   32,  16,  20);
+    app_addTask(app_task_32ms,   64,  32,  20);
+    app_addTask(app_task_64ms,  128,  64, 250); // PT1000 conversion
+    app_addTask(app_task_128ms, 256, 128, 150); // S0 power (32 bit division)
 }
 
 
@@ -58,11 +118,19 @@ void app_test () {
     }
 }
 
+// calibration 233 per LSB of 8 bit value, offset 279
+static uint16_t app_adcToCurr4To20mA (uint16_t adc) {
+    return (((uint32_t)adc * 233) >> (SYS_ADC_BITS - 8)) + 279;
+}
+
 void app_main (void) {
     if (test) {
         app_test();
     }
-    app.curr4To20mAx2048 = (uint16_t)sys.adc0_u8 * 233 + 279; 
+    app.curr4To20mAx2048 = app_adcToCurr4To20mA(sys_getAdcFiltered());
+    if (sys_isOvercurrentFault()) {
+        sys_setEvent(GLOBAL_EVENT_MODBUS_ERROR);
+    }
     if (app.curr4To20mAx2048 < (4 * 2048)) {
         app.pwmLedTimer = 0;
     } else {
@@ -79,27 +147,488 @@ uint16_t app_getSetpoint4To20mA () {
     return app.setpoint4To20mAx2028;
 }
 
-uint8_t app_setSetpoint4To20mA (uint16_t value) {
+static void app_applySetpoint4To20mA (uint16_t value) {
+    uint8_t sreg = sys_enterCritical();
     app.setpoint4To20mAx2028 = value;
-    uint32_t x1 = (uint32_t)value * 297 + 32768;
-    uint16_t x2 = x1 >> 16;
-    if (x2 > 255) { 
-        x2 = 255;
+    if (app.pi.mode == APP_CONTROL_OPEN_LOOP) {
+        uint32_t x1 = (uint32_t)value * 297 + 32768;
+        uint16_t x2 = x1 >> 16;
+        if (x2 > 255) { 
+            x2 = 255;
+        }
+        app.pi.pwm = x2;
+        sys_setPwm4To20mA(x2);
+    }
+    sys_leaveCritical(sreg);
+}
+
+// writing the 4-20mA setpoint directly stops the power setpoint ramp
+uint8_t app_setSetpoint4To20mA (uint16_t value) {
+    uint8_t sreg = sys_enterCritical();
+    app.power.setpoint = APP_POWER_INACTIVE;
+    app_applySetpoint4To20mA(value);
+    sys_leaveCritical(sreg);
+    return 0;
+}
+
+uint16_t app_getControl4To20mA () {
+    if (app.pi.mode == APP_CONTROL_CLOSED_LOOP && app.pi.saturated) {
+        return APP_CONTROL_SATURATED;
+    }
+    return app.pi.mode;
+}
+
+uint8_t app_setControl4To20mA (uint16_t mode) {
+    if (mode != APP_CONTROL_OPEN_LOOP && mode != APP_CONTROL_CLOSED_LOOP) {
+        return 1;
+    }
+    uint8_t sreg = sys_enterCritical();
+    app.pi.mode = mode;
+    app.pi.integ = 0;
+    app.pi.saturated = 0;
+    app_applySetpoint4To20mA(app.setpoint4To20mAx2028);
+    sys_leaveCritical(sreg);
+    return 0;
+}
+
+//--------------------------------------------------------
+// over-current trip, the ADC ISR compares the raw conversions of the 4-20mA channel
+
+// inverse of app_adcToCurr4To20mA for a raw conversion (10 bit), rounded up
+static uint16_t app_curr4To20mAToAdcRaw (uint16_t curr) {
+    if (curr <= 279) {
+        return 0;
+    }
+    return (((uint32_t)(curr - 279) << (10 - 8)) + 232) / 233;
+}
+
+uint16_t app_getOvercurrentTrip () {
+    return app.overcurrentTripx2048;
+}
+
+// value: [mA/2048], 0 = off, levels below 4mA or beyond the ADC range are rejected
+uint8_t app_setOvercurrentTrip (uint16_t value) {
+    uint16_t level = SYS_OVERCURRENT_OFF;
+    if (value > 0) {
+        if (value < (4 * 2048)) {
+            return 1;
+        }
+        level = app_curr4To20mAToAdcRaw(value);
+        if (level > 1023) {
+            return 1;
+        }
+    }
+    app.overcurrentTripx2048 = value;
+    sys_setOvercurrentLevel(level);
+    return 0;
+}
+
+uint16_t app_getFault () {
+    return sys_isOvercurrentFault() ? APP_FAULT_OVERCURRENT : 0;
+}
+
+// only 0 is accepted, the 4-20mA setpoint is set to 0 and must be written again
+uint8_t app_setFault (uint16_t value) {
+    if (value != 0) {
+        return 1;
+    }
+    uint8_t sreg = sys_enterCritical();
+    app_setSetpoint4To20mA(0);
+    app.pi.integ = 0;
+    sys_clearOvercurrentFault();
+    sys_leaveCritical(sreg);
+    return 0;
+}
+
+//--------------------------------------------------------
+// power setpoint, converted to the 4-20mA setpoint by the power table
+
+// linear interpolation, the table must be monotonic increasing
+static uint16_t app_powerToCurr4To20mA (uint16_t watts) {
+    const uint16_t *t = app.power.table.watts;
+    if (watts <= t[0]) {
+        return 0;
+    }
+    for (uint8_t i = 0; i < APP_POWER_TABLE_SIZE - 1; i++) {
+        if (watts <= t[i + 1]) {
+            // watts > t[i] -> t[i + 1] - t[i] > 0
+            uint16_t frac = ((uint32_t)(watts - t[i]) << 11) / (t[i + 1] - t[i]);
+            return ((APP_POWER_TABLE_MIN_MA + i) << 11) + frac;
+        }
+    }
+    return (APP_POWER_TABLE_MIN_MA + APP_POWER_TABLE_SIZE - 1) << 11;
+}
+
+static uint16_t app_curr4To20mAToPower (uint16_t x2048) {
+    const uint16_t *t = app.power.table.watts;
+    if (x2048 < (APP_POWER_TABLE_MIN_MA << 11)) {
+        return 0;
+    }
+    uint8_t i = (x2048 >> 11) - APP_POWER_TABLE_MIN_MA;
+    if (i >= APP_POWER_TABLE_SIZE - 1) {
+        return t[APP_POWER_TABLE_SIZE - 1];
+    }
+    return t[i] + (((int32_t)(t[i + 1] - t[i]) * (x2048 & 0x7ff)) >> 11);
+}
+
+// called every 1ms, ramp and 4-20mA setpoint follow the power setpoint
+static void app_rampPower (void) {
+    struct App_Power *p = &app.power;
+    if (p->setpoint == APP_POWER_INACTIVE) {
+        return;
+    }
+    uint32_t target = (uint32_t)p->setpoint * 1000;
+    uint32_t ramp = p->ramp;
+    if (ramp < target) {
+        ramp = (p->slewUp == 0 || target - ramp <= p->slewUp) ? target : ramp + p->slewUp;
+    } else if (ramp > target) {
+        ramp = (p->slewDown == 0 || ramp - target <= p->slewDown) ? target : ramp - p->slewDown;
+    } else if (!p->pending) {
+        return;
+    }
+    p->pending = 0;
+    p->ramp = ramp;
+    app_applySetpoint4To20mA(app_powerToCurr4To20mA(ramp / 1000));
+}
+
+uint16_t app_getPowerSetpoint () {
+    return app.power.setpoint;
+}
+
+// APP_POWER_INACTIVE keeps the actual 4-20mA setpoint
+// the ramp starts at the power of the actual 4-20mA setpoint
+uint8_t app_setPowerSetpoint (uint16_t watts) {
+    uint8_t sreg = sys_enterCritical();
+    if (app.power.setpoint == APP_POWER_INACTIVE) {
+        app.power.ramp = (uint32_t)app_curr4To20mAToPower(app.setpoint4To20mAx2028) * 1000;
+    }
+    app.power.setpoint = watts;
+    app.power.pending = 1;
+    sys_leaveCritical(sreg);
+    return 0;
+}
+
+uint16_t app_getPowerRamp () {
+    uint8_t sreg = sys_enterCritical();
+    uint32_t rv = app.power.ramp;
+    sys_leaveCritical(sreg);
+    return rv / 1000;
+}
+
+uint16_t app_getPowerSlewUp () {
+    return app.power.slewUp;
+}
+
+uint8_t app_setPowerSlewUp (uint16_t wattsPerSecond) {
+    uint8_t sreg = sys_enterCritical();
+    app.power.slewUp = wattsPerSecond;
+    sys_leaveCritical(sreg);
+    return 0;
+}
+
+uint16_t app_getPowerSlewDown () {
+    return app.power.slewDown;
+}
+
+uint8_t app_setPowerSlewDown (uint16_t wattsPerSecond) {
+    uint8_t sreg = sys_enterCritical();
+    app.power.slewDown = wattsPerSecond;
+    sys_leaveCritical(sreg);
+    return 0;
+}
+
+uint8_t app_getPowerTable (uint16_t index, uint16_t *watts) {
+    if (index >= APP_POWER_TABLE_SIZE) {
+        return 1;
     }
-    sys_setPwm4To20mA(x2);
+    *watts = app.power.table.watts[index];
     return 0;
 }
 
+uint8_t app_setPowerTable (uint16_t index, uint16_t watts) {
+    uint8_t value[2] = { watts >> 8, watts & 0xff };
+    return app_writePowerTable(index, 1, value);
+}
+
+// values: big endian, FC 0x10 writes the block at once, so a new table is checked as a whole
+// the table must stay monotonic increasing, otherwise nothing is changed
+// the EEPROM is written in the background by app_writeEeprom(), the first write stores the whole table
+uint8_t app_writePowerTable (uint16_t index, uint8_t quantity, const uint8_t values[]) {
+    if (index >= APP_POWER_TABLE_SIZE || quantity > APP_POWER_TABLE_SIZE - index) {
+        return 1;
+    }
+    uint16_t watts[APP_POWER_TABLE_SIZE];
+    memcpy(watts, app.power.table.watts, sizeof(watts));
+    for (uint8_t i = 0; i < quantity; i++) {
+        watts[index + i] = values[2 * i] << 8 | values[2 * i + 1];
+    }
+    for (uint8_t i = 1; i < APP_POWER_TABLE_SIZE; i++) {
+        if (watts[i] < watts[i - 1]) {
+            return 1;
+        }
+    }
+    uint8_t sreg = sys_enterCritical();
+    memcpy(app.power.table.watts, watts, sizeof(watts));
+    app.power.pending = 1;
+    sys_leaveCritical(sreg);
+    if (app.power.table.magic != APP_POWER_TABLE_MAGIC) {
+        app.power.table.magic = APP_POWER_TABLE_MAGIC;
+        app.power.eeDirty = 0xffffffff >> (32 - sizeof(app.power.table));
+    } else {
+        uint8_t first = offsetof(struct App_PowerTable, watts) + 2 * index;
+        app.power.eeDirty |= ((1UL << (2 * quantity)) - 1) << first;
+    }
+    return 0;
+}
+
+// called every 1ms by the main loop, writes at most one byte of the power table to EEPROM
+// a byte write takes 3.4ms, meanwhile the EEPROM is not ready and nothing is done here
+// the magic is written last, a reset before keeps the table of the previous complete write
+void app_writeEeprom (void) {
+    uint32_t dirty = app.power.eeDirty;
+    if (dirty == 0 || !eeprom_is_ready()) {
+        return;
+    }
+    uint8_t n = (dirty & ~3UL) ? 2 : 0;
+    while (!(dirty & (1UL << n))) {
+        n++;
+    }
+    eeprom_update_byte((uint8_t *)&app_eePowerTable + n, ((uint8_t *)&app.power.table)[n]);
+    app.power.eeDirty = dirty & ~(1UL << n);
+}
+
+// PI control of the 4-20mA output, called every 1ms
+// u = setpoint * 297 (feed forward) + KP * e + integ, all in PWM/65536
+// anti windup: integ is not changed while the output is saturated in direction of e
+// the measurement is the decimated ADC value (no IIR, new value every 2.6ms)
+static void app_control4To20mA (void) {
+    struct App_Pi4To20mA *pi = &app.pi;
+    if (pi->mode != APP_CONTROL_CLOSED_LOOP) {
+        return;
+    }
+    uint16_t setpoint = app.setpoint4To20mAx2028;
+    if (setpoint == 0) {
+        pi->integ = 0;
+        pi->saturated = 0;
+        pi->pwm = 0;
+        sys_setPwm4To20mA(0);
+        return;
+    }
+    int32_t e = (int32_t)setpoint - app_adcToCurr4To20mA(sys_getAdcValue());
+    int32_t u = (int32_t)setpoint * 297 + e * GLOBAL_4TO20MA_PI_KP + pi->integ + 32768;
+    uint8_t saturated = 0;
+    if (u < 0) {
+        u = 0;
+        saturated = e < 0;
+    } else if (u > (255L << 16)) {
+        u = 255L << 16;
+        saturated = e > 0;
+    }
+    if (!saturated) {
+        pi->integ += e * GLOBAL_4TO20MA_PI_KI;
+        if (pi->integ > (255L << 16)) {
+            pi->integ = 255L << 16;
+        } else if (pi->integ < -(255L << 16)) {
+            pi->integ = -(255L << 16);
+        }
+    }
+    pi->saturated = saturated;
+    pi->pwm = u >> 16;
+    sys_setPwm4To20mA(pi->pwm);
+}
+
 uint16_t app_getCurr4To20mA () {
 
     return app.curr4To20mAx2048;
 }
 
+uint16_t app_getSensor0Time () {
+    return app.sensor0Time;
+}
+
+uint16_t app_getPt1000At () {
+    uint8_t sreg = sys_enterCritical();
+    uint16_t rv = app.pt1000At;
+    sys_leaveCritical(sreg);
+    return rv;
+}
+
+uint16_t app_getPt1000Temp1 () {
+    uint8_t sreg = sys_enterCritical();
+    int16_t rv = app.pt1000Temp[0];
+    sys_leaveCritical(sreg);
+    return rv;
+}
+
+uint16_t app_getPt1000Temp2 () {
+    uint8_t sreg = sys_enterCritical();
+    int16_t rv = app.pt1000Temp[1];
+    sys_leaveCritical(sreg);
+    return rv;
+}
+
+uint16_t app_getSensor0Power () {
+    return app.sensor0Power;
+}
+
+// called by pin change ISR, timestamp from sys_getTimestamp()
+void app_handleSensor0Edge (uint8_t on, uint32_t timestamp) {
+    struct App_Sensor0 *s = &app.sensor0;
+    if (on) {
+        s->onAt = timestamp;
+        return;
+    }
+    if ((timestamp - s->onAt) < (uint32_t)GLOBAL_S0_MIN_PULSE_MS * APP_S0_TICKS_PER_MS) {
+        s->glitches++;
+        return;
+    }
+    s->pulseAt[s->wpos] = timestamp;
+    s->pulseMs = sys_getUptimeMs();
+    s->wpos = (s->wpos + 1) & (GLOBAL_S0_PULSES - 1);
+    if (s->size < GLOBAL_S0_PULSES) {
+        s->size++;
+    }
+    if (app.sensor0Cnt < 0xffffffff) {
+        app.sensor0Cnt++;
+    }
+}
+
+uint16_t app_getSensor0PulseMs () {
+    uint8_t sreg = sys_enterCritical();
+    uint16_t rv = app.sensor0.pulseMs;
+    sys_leaveCritical(sreg);
+    return rv;
+}
+
+static uint32_t app_getSensor0PulseAt (uint8_t wpos, uint8_t back) {
+    uint8_t sreg = sys_enterCritical();
+    uint32_t rv = app.sensor0.pulseAt[(wpos - back) & (GLOBAL_S0_PULSES - 1)];
+    sys_leaveCritical(sreg);
+    return rv;
+}
+
+// power from the pulses within GLOBAL_S0_WINDOW_MS before the last pulse,
+// limited by one pulse since the last pulse (falling power)
+// timestamps are read one by one, so the pin change ISR is not blocked by the loop,
+// an entry overwritten meanwhile is newer than last and stops the loop
+static void app_updateSensor0Power (void) {
+    struct App_Sensor0 *s = &app.sensor0;
+    uint8_t sreg = sys_enterCritical();
+    uint32_t now = sys_getTimestamp();
+    uint8_t wpos = s->wpos;
+    uint8_t size = s->size;
+    uint32_t last = s->pulseAt[(wpos - 1) & (GLOBAL_S0_PULSES - 1)];
+    if (size > 0 && (now - last) > (uint32_t)GLOBAL_S0_TIMEOUT_MS * APP_S0_TICKS_PER_MS) {
+        s->size = 0; // avoids timestamp wrap around
+        size = 0;
+    }
+    sys_leaveCritical(sreg);
+
+    uint32_t since = now - last;
+    uint32_t first = last;
+    uint32_t previous = last;
+    uint8_t pulses = 0;
+    for (uint8_t i = 2; i <= size; i++) {
+        uint32_t t = app_getSensor0PulseAt(wpos, i);
+        if (pulses > 0 && (last - t) > (uint32_t)GLOBAL_S0_WINDOW_MS * APP_S0_TICKS_PER_MS) {
+            break;
+        }
+        if (pulses == 0) {
+            previous = t;
+        }
+        first = t;
+        pulses++;
+    }
+
+    if (size == 0 || since > (uint32_t)APP_S0_SENSOR0TIME_TIMEOUT_MS * APP_S0_TICKS_PER_MS) {
+        app.sensor0Time = 0xffff;
+    } else if (pulses > 0) {
+        uint32_t t = (last - previous) / APP_S0_SENSOR0TIME_TICKS;
+        app.sensor0Time = t > 0xfffe ? 0xfffe : t;
+    }
+
+    if (pulses == 0) {
+        app.sensor0Power = 0;
+        return;
+    }
+    uint32_t ticks = last - first;
+    if (since > ticks / pulses) {
+        pulses = 1;
+        ticks = since;
+    }
+    ticks >>= 8;
+    uint32_t p = ticks == 0 ? 0xffff : (pulses * APP_S0_POWER_NUM) / ticks;
+    app.sensor0Power = p > 0xffff ? 0xffff : p;
+}
 
 
+//--------------------------------------------------------
+// sample fifo, single writer (app_task_2ms) and single reader (main loop),
+// wpos and rpos are bytes and only changed by their owner
+
+uint16_t app_getSampleDivider () {
+    return app.samples.divider;
+}
+
+uint8_t app_setSampleDivider (uint16_t divider) {
+    if (divider > 255) {
+        return 1;
+    }
+    uint8_t sreg = sys_enterCritical();
+    app.samples.divider = divider;
+    app.samples.timer = 0;
+    sys_leaveCritical(sreg);
+    return 0;
+}
+
+uint16_t app_getSampleFifoCount () {
+    return (app.samples.wpos - app.samples.rpos) & (GLOBAL_SAMPLE_FIFO_SIZE - 1);
+}
+
+uint16_t app_getSampleLost () {
+    uint8_t sreg = sys_enterCritical();
+    uint16_t rv = app.samples.lost;
+    sys_leaveCritical(sreg);
+    return rv;
+}
+
+// returns 1 if fifo is empty
+uint8_t app_popSample (struct App_Sample *sample) {
+    uint8_t r = app.samples.rpos;
+    if (r == app.samples.wpos) {
+        return 1;
+    }
+    *sample = app_samples[r];
+    app.samples.rpos = (r + 1) & (GLOBAL_SAMPLE_FIFO_SIZE - 1);
+    return 0;
+}
+
+static void app_pushSample (void) {
+    struct App_SampleFifo *f = &app.samples;
+    if (f->divider == 0 || ++f->timer < f->divider) {
+        return;
+    }
+    f->timer = 0;
+    uint8_t w = f->wpos;
+    uint8_t next = (w + 1) & (GLOBAL_SAMPLE_FIFO_SIZE - 1);
+    if (next == f->rpos) {
+        f->lost++;
+    } else {
+        struct App_Sample *s = &app_samples[w];
+        s->current = app_adcToCurr4To20mA(sys_getAdcValue());
+        s->setpoint = app.setpoint4To20mAx2028;
+        s->sensor0Cnt = app.sensor0Cnt;
+        s->seq = f->seq;
+        f->wpos = next;
+    }
+    f->seq++;
+}
+
 //--------------------------------------------------------
 
 void app_task_1ms (void) {
+    app_rampPower();
+    app_control4To20mA();
     static uint16_t timer = 0;
     if (timer <= 180) {
         timer = 1000;
@@ -119,33 +648,11 @@ void app_task_1ms (void) {
 }
 
 void app_task_2ms (void) {
-    static uint8_t oldS0 = 0;
-    static uint16_t timer = 0;
-    if (timer < 5000) {
-        timer++;
-    } else {
-        app.sensor0Time = 0xffff;
-    }
-    if (sys_isSensor1On()) {
-        sys_setLedSensor1(1); // S0 Energymeter
-        oldS0 = 1;
-    } else {
-        sys_setLedSensor1(0);
-        if (oldS0 == 1) {
-            oldS0 = 0;
-            if (app.sensor0Cnt < 0xffffffff) {
-                app.sensor0Cnt++;
-            }
-            app.sensor0Time = timer;            
-            timer = 0;
-        }
-    }
-
+    app_pushSample();
 }
 
 void app_task_4ms (void) {
     if (test) {
-        sys_setLedSensor1(sys_isSensor1On());
         sys_setLedSensor2(sys_isSensor2On());
     }
 }
@@ -164,21 +671,25 @@ void app_task_32ms (void) {
 }
 
 void app_task_64ms (void) {
+    app.pt1000Temp[0] = pt1000_toTemperature(sys_getAdcChannel(SYS_ADC_CH_PT1000_1));
+    app.pt1000Temp[1] = pt1000_toTemperature(sys_getAdcChannel(SYS_ADC_CH_PT1000_2));
+    app.pt1000At = sys_getAdcChannelAt(SYS_ADC_CH_PT1000_1);
     if (sys_isSw2On()) {
         sys_toggleLifeLed();
     }
 }
 
 void app_task_128ms (void) {
+    app_updateSensor0Power();
     if (!sys_isSw2On()) {
         sys_toggleLifeLed();
     }
-    if (sys_clearEvent(GLOBAL_EVENT_MODBUS_ASCII_FRAME)) {
+    if (sys_clearEvent(GLOBAL_EVENT_MODBUS_FRAME)) {
         sys_setLedSensor2(1);
     } else {
         sys_setLedSensor2(0);
     }
-    if (sys_clearEvent(GLOBAL_EVENT_MODBUS_ASCII_ERROR)) {
+    if (sys_clearEvent(GLOBAL_EVENT_MODBUS_ERROR)) {
         sys_setLedPT1000Red(0, 1);
     } else {
         sys_setLedPT1000Red(0, 0);
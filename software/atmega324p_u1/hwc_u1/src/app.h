@@ -9,15 +9,87 @@ struct App_ErrCounter { // size word aligned !
     uint8_t modbus_ascii_crlf;
 };
 
+struct App_Sensor0 {
+    uint32_t onAt;                         // timestamp of rising edge
+    uint32_t pulseAt[GLOBAL_S0_PULSES];    // ring buffer, timestamps of pulses (falling edge)
+    uint8_t  wpos;
+    uint8_t  size;                         // valid timestamps in pulseAt
+    uint16_t glitches;                     // pulses shorter than GLOBAL_S0_MIN_PULSE_MS
+    uint16_t pulseMs;                      // uptime [ms] (low word) of last pulse
+};
+
+#define APP_CONTROL_OPEN_LOOP       0
+#define APP_CONTROL_CLOSED_LOOP     1
+#define APP_CONTROL_SATURATED       2   // closed loop, PWM at limit (read only)
+
+struct App_Pi4To20mA {
+    uint8_t  mode;        // APP_CONTROL_OPEN_LOOP or APP_CONTROL_CLOSED_LOOP
+    uint8_t  saturated;   // PWM at 0 or 255, integrator stopped
+    uint8_t  pwm;
+    int32_t  integ;       // integral part, PWM/65536
+};
+
+#define APP_FAULT_OVERCURRENT       0x0001  // 4-20mA output over trip level, PWM and SSRs off
+
+#define APP_POWER_TABLE_SIZE       15
+#define APP_POWER_TABLE_MIN_MA      6       // watts[i] is the power at (APP_POWER_TABLE_MIN_MA + i) mA
+#define APP_POWER_INACTIVE          0xffff  // 4-20mA setpoint written directly
+
+#if (APP_POWER_TABLE_SIZE + 1) * 2 > 32
+  #error "Error: APP_POWER_TABLE_SIZE value over maximum (15), App_Power.eeDirty has 32 bits"
+#endif
+
+struct App_PowerTable {
+    uint16_t magic;                         // APP_POWER_TABLE_MAGIC if stored in EEPROM
+    uint16_t watts[APP_POWER_TABLE_SIZE];
+};
+
+struct App_Power {
+    uint16_t setpoint;    // [W] or APP_POWER_INACTIVE
+    uint16_t slewUp;      // [W/s], 0 = unlimited
+    uint16_t slewDown;    // [W/s], 0 = unlimited
+    uint8_t  pending;     // setpoint changed, 4-20mA setpoint must be updated
+    uint32_t ramp;        // [mW], follows setpoint with slewUp/slewDown
+    uint32_t eeDirty;     // bytes of table not yet stored in EEPROM (bit n = byte n), see app_writeEeprom
+    struct App_PowerTable table;
+};
+
+#define APP_SAMPLE_WORDS            3
+
+struct App_Sample {
+    uint16_t current;     // curr4To20mAx2048, not filtered
+    uint16_t setpoint;    // setpoint4To20mAx2048
+    uint8_t  sensor0Cnt;  // low byte of S0 pulse counter
+    uint8_t  seq;         // sequence number, gaps show lost samples
+};
+
+// ring buffer app_samples, written by app_task_2ms, read by main loop (Modbus FC 0x18)
+struct App_SampleFifo {
+    uint8_t  divider;     // sample every divider * 2ms, 0 = off
+    uint8_t  timer;
+    uint8_t  seq;
+    uint8_t  wpos;
+    uint8_t  rpos;
+    uint16_t lost;        // samples not stored because fifo was full
+};
+
 struct App {
     uint8_t version;
     uint8_t debugLevel;
     struct App_ErrCounter err;
     uint16_t setpoint4To20mAx2028;
     uint16_t curr4To20mAx2048;
+    uint16_t overcurrentTripx2048;  // 0 = off
+    struct App_Pi4To20mA pi;
+    struct App_Power power;
+    struct App_SampleFifo samples;
     uint8_t  pwmLedTimer;
     uint16_t sensor0Time;
     uint32_t sensor0Cnt;
+    uint16_t sensor0Power;   // [0.1W]
+    struct App_Sensor0 sensor0;
+    int16_t  pt1000Temp[2];  // [1/100 degree], PT1000_INVALID if sensor open or shorted
+    uint16_t pt1000At;       // uptime [ms] (low word) of ADC value used for pt1000Temp[0]
 };
 
 extern struct App app;
@@ -29,11 +101,39 @@ extern struct App app;
 
 void app_init ();
 void app_main ();
+void app_handleSensor0Edge (uint8_t on, uint32_t timestamp);
+void app_writeEeprom ();
 
 uint8_t  app_setSetpoint4To20mA (uint16_t value);
 uint16_t app_getSetpoint4To20mA ();
 uint16_t app_getCurr4To20mA ();
-uint32_t app_getSensor0Cnt ();
+uint16_t app_getControl4To20mA ();
+uint8_t  app_setControl4To20mA (uint16_t mode);
+uint16_t app_getOvercurrentTrip ();
+uint8_t  app_setOvercurrentTrip (uint16_t value);
+uint16_t app_getFault ();
+uint8_t  app_setFault (uint16_t value);
+uint16_t app_getPowerSetpoint ();
+uint8_t  app_setPowerSetpoint (uint16_t watts);
+uint16_t app_getPowerRamp ();
+uint16_t app_getPowerSlewUp ();
+uint8_t  app_setPowerSlewUp (uint16_t wattsPerSecond);
+uint16_t app_getPowerSlewDown ();
+uint8_t  app_setPowerSlewDown (uint16_t wattsPerSecond);
+uint8_t  app_getPowerTable (uint16_t index, uint16_t *watts);
+uint8_t  app_setPowerTable (uint16_t index, uint16_t watts);
+uint8_t  app_writePowerTable (uint16_t index, uint8_t quantity, const uint8_t values[]);
+uint16_t app_getSampleDivider ();
+uint8_t  app_setSampleDivider (uint16_t divider);
+uint16_t app_getSampleFifoCount ();
+uint16_t app_getSampleLost ();
+uint8_t  app_popSample (struct App_Sample *sample);
+uint16_t app_getSensor0Time ();
+uint16_t app_getSensor0Power ();
+uint16_t app_getSensor0PulseMs ();
+uint16_t app_getPt1000At ();
+uint16_t app_getPt1000Temp1 ();
+uint16_t app_getPt1000Temp2 ();
 
 
 void app_task_1ms   ();
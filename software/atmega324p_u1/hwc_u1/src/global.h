@@ -7,12 +7,43 @@
 #endif
 
 #define GLOBAL_UART0_BITRATE  115200
-#define GLOBAL_UART1_BITRATE  115200
+#define GLOBAL_UART1_BITRATE  115200  // after reset and after fallback (see modbus_setUart1Bitrate)
+#define GLOBAL_UART1_CONFIRM_MS   1000  // bit rate change must be confirmed by a valid frame within this time
+#define GLOBAL_UART1_IDLE_MS     30000  // no valid frame for this time -> back to GLOBAL_UART1_BITRATE
 #define GLOBAL_UART0_RXBUFSIZE  8
 #define GLOBAL_UART0_TXBUFSIZE  128
+#define GLOBAL_UART1_TXBUFSIZE  160
+#define GLOBAL_LOG_BUFSIZE      128  // binary log ring buffer on UART0 (power of 2, max. 128)
+
+#define GLOBAL_ADC_OVERSAMPLING_BITS  2  // 4^n samples per value: 2 -> 12 bit (4-20mA 391Hz, PT1000 39Hz), 3 -> 13 bit (98Hz, 9.8Hz)
+#define GLOBAL_ADC_FILTER_SHIFT       3  // IIR low pass y += (x - y) / 2^n, 0 = off
+#define GLOBAL_ADC_VREF_MV         1100  // internal reference
+
+#define GLOBAL_PT1000_MV_AT_1200R   510  // front end output at 1200 Ohm (trimmed by RV1/RV2)
+#define GLOBAL_PT1000_UV_PER_OHM   2000  // front end gain
+
+#define GLOBAL_4TO20MA_CONTROL        1  // 0 = open loop, 1 = PI control of measured current
+#define GLOBAL_4TO20MA_PI_KP         74  // PWM/65536 per mA/2048 (feed forward slope is 297)
+#define GLOBAL_4TO20MA_PI_KI         48  // PWM/65536 per mA/2048 and ms
+#define GLOBAL_OVERCURRENT_TRIP   45056  // over-current trip of 4-20mA output [mA/2048] (22mA), 0 = off
+#define GLOBAL_OVERCURRENT_SAMPLES    2  // consecutive ADC conversions (100us) over trip level
+
+#define GLOBAL_POWER_SLEW_UP         25  // power setpoint ramp [W/s], 0 = unlimited
+#define GLOBAL_POWER_SLEW_DOWN        0
+
+#define GLOBAL_SAMPLE_FIFO_SIZE      64  // samples (6 bytes), power of 2 (max. 128)
+
+#define GLOBAL_S0_PULSES_PER_KWH   2000
+#define GLOBAL_S0_PULSES             16  // timestamp ring buffer size (power of 2)
+#define GLOBAL_S0_MIN_PULSE_MS       10  // shorter pulses are ignored (S0 standard: >= 30ms)
+#define GLOBAL_S0_WINDOW_MS       10000  // power is averaged over the pulses of this window
+#define GLOBAL_S0_TIMEOUT_MS      60000  // no pulse for this time -> power 0
 
 #define GLOBAL_MODBUS_DEVICEADDR 1
 #define GLOBAL_MODBUS_ASCII_BUFSIZE  64
+#define GLOBAL_MODBUS_RTU_BUFSIZE    64
+#define GLOBAL_MODBUS_MODE            0  // 0=auto detect, 1=ASCII, 2=RTU
+#define GLOBAL_MODBUS_SNAPSHOT_WORDS 32  // debug window reads, words copied with interrupts disabled (about 1us per word)
 #define GLOBAL_MODBUS_DEBUGLEVEL 0
 #define GLOBAL_MODBUS_ECHOREQUEST 1
 
@@ -26,12 +57,12 @@
 #define GLOBAL_DEBUG_LEVEL_FINEST  60
 #define GLOBAL_DEBUG_LEVEL_ALL    255
 
-#define GLOBAL_EVENT_MODBUS_ASCII_FRAME 0x01
-#define GLOBAL_EVENT_MODBUS_ASCII_ERROR 0x02
-#define GLOBAL_EVENT_MODBUS_BUSY        0x04
-#define GLOBAL_EVENT_3                  0x08
-#define GLOBAL_EVENT_4                  0x10
-#define GLOBAL_EVENT_5                  0x20
+#define GLOBAL_EVENT_MODBUS_FRAME       0x01
+#define GLOBAL_EVENT_MODBUS_ERROR       0x02
+#define GLOBAL_EVENT_MODBUS_RX          0x04  // frame in receive buffer (ASCII or RTU), for main loop
+#define GLOBAL_EVENT_ADC                0x08  // new filtered value of 4-20mA input, for main loop
+#define GLOBAL_EVENT_TICK               0x10  // every 1ms, for main loop
+#define GLOBAL_EVENT_UART1_TX           0x20  // space in UART1 transmit buffer (sys_waitUart1TxFree), for main loop
 #define GLOBAL_EVENT_6                  0x40
 #define GLOBAL_EVENT_7                  0x80
 
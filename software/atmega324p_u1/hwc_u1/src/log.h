@@ -0,0 +1,30 @@
+#ifndef LOG_H_
+#define LOG_H_
+
+// binary log on UART0, written by sys_log() into a RAM ring buffer and sent by USART0_UDRE_vect
+// record: LOG_SYNC, id, length, uptime [ms] (low word, little endian), data[length]
+// bytes outside of records are text (printf), so text and records can be mixed on UART0
+// host/log_decode.c uses LOG_TABLE to print the records
+
+#define LOG_SYNC          0xa5
+#define LOG_HEADER_SIZE   5
+
+#define LOG_FORMAT_HEX    0  // data as hex bytes
+#define LOG_FORMAT_U16    1  // data as unsigned 16 bit values (little endian)
+
+// L(id, name, format, text)
+#define LOG_TABLE(L) \
+    L(1, LOG_MODBUS_ASCII_REQUEST,  LOG_FORMAT_HEX, "Modbus ASCII request") \
+    L(2, LOG_MODBUS_ASCII_RESPONSE, LOG_FORMAT_HEX, "Modbus ASCII response") \
+    L(3, LOG_MODBUS_RTU_REQUEST,    LOG_FORMAT_HEX, "Modbus RTU request") \
+    L(4, LOG_MODBUS_RTU_RESPONSE,   LOG_FORMAT_HEX, "Modbus RTU response") \
+    L(5, LOG_UART1_RX,              LOG_FORMAT_HEX, "UART1 rx") \
+    // end of LOG_TABLE
+
+#define LOG_ID_ENUM(id, name, format, text) name = id,
+
+enum Log_Id {
+    LOG_TABLE(LOG_ID_ENUM)
+};
+
+#endif // LOG_H_
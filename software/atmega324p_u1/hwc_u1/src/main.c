@@ -19,6 +19,7 @@
 #include "./sys.h"
 #include "./modbus.h"
 #include "modbus_ascii.h"
+#include "modbus_rtu.h"
 #include "./app.h"
 
 // defines
@@ -37,6 +38,7 @@ const char MAIN_HELP[] = "\r\n";
 int main () {
     sys_init();
     modbusAscii_init();
+    modbusRtu_init();
     modbus_init();
 
     app_init();
@@ -46,11 +48,31 @@ int main () {
     // enable interrupt system
     sei();
 
+    // event driven, the CPU sleeps (idle mode) until an ISR posts one of the events
+    // received frames are handled next, large responses are continued when the UART1 transmit
+    // buffer has space again (GLOBAL_EVENT_UART1_TX)
+    // the tick event covers error counters, reports, timeouts and EEPROM writes
     while (1) {
-        sys_main();
-        modbusAscii_main();
-        modbus_main();
-        app_main();
+        uint16_t start;
+        Sys_Event events = sys_waitForEvents(GLOBAL_EVENT_MODBUS_RX | GLOBAL_EVENT_UART1_TX | GLOBAL_EVENT_ADC | GLOBAL_EVENT_TICK);
+        if (events & (GLOBAL_EVENT_MODBUS_RX | GLOBAL_EVENT_UART1_TX | GLOBAL_EVENT_TICK)) {
+            start = sys_getTaskTimer();
+            modbusAscii_main();
+            sys_updateTaskTime(SYS_TASKTIME_MODBUS_ASCII, start);
+            start = sys_getTaskTimer();
+            modbusRtu_main();
+            sys_updateTaskTime(SYS_TASKTIME_MODBUS_RTU, start);
+        }
+        if (events & GLOBAL_EVENT_TICK) {
+            sys_main();
+            modbus_main();
+            app_writeEeprom();
+        }
+        if (events & GLOBAL_EVENT_ADC) {
+            start = sys_getTaskTimer();
+            app_main();
+            sys_updateTaskTime(SYS_TASKTIME_APP, start);
+        }
     }
     return 0;
 }
@@ -1,22 +1,430 @@
 
 #include <string.h>
 #include <stdint.h>
+#include <avr/pgmspace.h>
 
 #include "global.h"
 #include "modbus.h"
 #include "modbus_ascii.h"
+#include "modbus_rtu.h"
+#include "modbus_register.h"
 #include "app.h"
 #include "sys.h"
 
 struct Modbus modbus;
 
+struct Modbus_Register {
+    uint16_t (*get)();
+    uint8_t  (*set)(uint16_t value);
+};
+
+#define MODBUS_REGISTER_ENTRY(addr, get, set) [addr] = { get, set },
+
+// holding register 0 ... MODBUS_REGISTER_SIZE - 1, indexed by address
+static const struct Modbus_Register modbus_register[MODBUS_REGISTER_SIZE] PROGMEM = {
+    MODBUS_REGISTER_TABLE(MODBUS_REGISTER_ENTRY)
+};
+
+static uint32_t modbus_sensor0Cnt = 0;
+static uint32_t modbus_uptimeMs = 0;
+
+// read response not fitting into the frame buffer, values are read while the frame is sent
+static struct {
+    uint16_t addr;
+    uint8_t  quantity;  // registers not sent yet
+} modbus_stream;
+
+// copy of a debug window range (0x0400 ... 0x1bff), so that a block read gets coherent values
+// invalidated with each request, a new copy is taken when the block leaves the copied range
+static struct {
+    const uint16_t *src;  // NULL = no copy
+    uint16_t first;       // word index in src
+    uint8_t  count;
+    uint16_t word[GLOBAL_MODBUS_SNAPSHOT_WORDS];
+} modbus_snapshot;
+
+// report contains the registers setpoint4To20mA ... fault (same layout as response of FC 0x03)
+#define MODBUS_REPORT_QUANTITY   (MODBUS_REGISTER_FAULT + 1)
+#define MODBUS_REPORT_LENGTH     (3 + 2 * MODBUS_REPORT_QUANTITY)  // address, function code, byte count, values
+#define MODBUS_REPORT_TICKS_PER_MS  (SYS_TIMESTAMP_FREQ / 1000)
+#define MODBUS_REPORT_CHECK_MS   16
+
+#if MODBUS_ASCII_FRAME_SIZE(MODBUS_REPORT_LENGTH) > GLOBAL_UART1_TXBUFSIZE - 1  // ring buffer keeps one byte free
+#error "report does not fit into UART1 transmit buffer"
+#endif
+
+#define MODBUS_UART1_BITRATE  ((uint16_t)(GLOBAL_UART1_BITRATE / 100))
+
+static void modbus_checkReport ();
+static void modbus_checkUart1 ();
+
 void modbus_init() {
     memset((void *)&modbus, 0, sizeof(modbus));
     modbus.version = 1;
     modbus.debugLevel = GLOBAL_DEBUG_LEVEL_NONE;
+    modbus.mode = GLOBAL_MODBUS_MODE;
+    modbus.rxMode = GLOBAL_MODBUS_MODE;
+    modbus.uart1.bitrate = MODBUS_UART1_BITRATE;
 }
 
 void modbus_main () {
+    if (modbus_isStreaming()) {
+        return; // nothing may be sent or switched before the end of the response
+    }
+    modbus_checkUart1();
+    if (modbus.uart1.pending == 0) {
+        // a report queued behind the response would be sent with the old bit rate and delay the switch
+        modbus_checkReport();
+    }
+}
+
+// called from USART1_RX_vect
+// as long as no valid frame is received (auto detect) both receivers get the byte
+void modbus_handleUart1Byte (uint8_t b) {
+    if (modbus.rxMode != MODBUS_MODE_RTU) {
+        modbusAscii_handleModbusAsciiByte((char)b);
+    }
+    if (modbus.rxMode != MODBUS_MODE_ASCII) {
+        modbusRtu_handleByte(b);
+    }
+}
+
+uint8_t modbus_setMode (uint16_t mode) {
+    if (mode > MODBUS_MODE_RTU) {
+        return 1;
+    }
+    // response is sent in old mode, frames in reception are discarded
+    uint8_t sreg = sys_enterCritical();
+    modbus.mode = mode;
+    modbus.rxMode = mode;
+    modbusAscii_reset();
+    modbusRtu_reset();
+    sys_leaveCritical(sreg);
+    return 0;
+}
+
+static void modbus_switchUart1 (uint16_t bitrate) {
+    uint32_t b = (uint32_t)bitrate * 100;
+    // frames in reception are discarded
+    uint8_t sreg = sys_enterCritical();
+    sys_setUart1Bitrate(b);
+    modbusRtu_setBitrate(b);
+    modbusAscii_reset();
+    modbusRtu_reset();
+    sys_leaveCritical(sreg);
+    modbus.uart1.bitrate = bitrate;
+    modbus.uart1.pending = 0;
+    modbus.uart1.confirmed = 0;
+    modbus.uart1.frameAt = sys_getUptimeMs();
+}
+
+static void modbus_checkUart1 () {
+    struct Modbus_Uart1 *u = &modbus.uart1;
+    if (u->pending != 0) {
+        if (sys_isUart1TxComplete()) { // response sent with old bit rate
+            modbus_switchUart1(u->pending);
+        }
+        return;
+    }
+    if (u->bitrate == MODBUS_UART1_BITRATE) {
+        return;
+    }
+    uint32_t ms = sys_getUptimeMs() - u->frameAt;
+    if (ms >= (u->confirmed ? GLOBAL_UART1_IDLE_MS : GLOBAL_UART1_CONFIRM_MS)) {
+        sys_inc16BitCnt(&modbus.err.uart1Fallback_u16);
+        modbus_switchUart1(MODBUS_UART1_BITRATE);
+    }
+}
+
+uint16_t modbus_getUart1Bitrate () {
+    return modbus.uart1.bitrate;
+}
+
+// the master proposes a new bit rate, the response is still sent with the old one
+// the master must send a frame with the new bit rate within GLOBAL_UART1_CONFIRM_MS
+uint8_t modbus_setUart1Bitrate (uint16_t bitrate) {
+    switch (bitrate) {
+        case MODBUS_UART1_BITRATE: case 5000: case 7500: case 15000: break;
+        default: return 1;
+    }
+    modbus.uart1.pending = bitrate == modbus.uart1.bitrate ? 0 : bitrate;
+    return 0;
+}
+
+uint8_t modbus_exceptionResponse (uint8_t buffer[], uint8_t exceptionCode) {
+    buffer[1] |= 0x80;
+    buffer[2] = exceptionCode;
+    return 3;
+}
+
+// writes byte count and register values into buffer[2...], returns response length (0 on error)
+uint8_t modbus_readHoldRegisters (uint8_t buffer[], uint16_t addr, uint8_t quantity) {
+    uint8_t i = 2;
+    buffer[i++] = quantity * 2;
+    while (quantity-- > 0) {
+        uint16_t value;
+        if (modbus_readHoldRegister(addr++, &value)) {
+            return 0;
+        }
+        buffer[i++] = value >> 8;
+        buffer[i++] = value & 0xff;
+    }
+    return i;
+}
+
+// response of FC 0x03/0x17, returns response length
+// if the values do not fit into buffer, only address, function code and byte count are returned
+// and the values follow by modbus_streamResponse()
+static uint8_t modbus_readResponse (uint8_t buffer[], uint16_t addr, uint8_t quantity, uint8_t size) {
+    if (3 + 2 * quantity <= size) {
+        uint8_t rv = modbus_readHoldRegisters(buffer, addr, quantity);
+        return rv > 0 ? rv : modbus_exceptionResponse(buffer, 0x03);
+    }
+    for (uint8_t i = 0; i < quantity; i++) {
+        if (modbus_readHoldRegister(addr + i, NULL)) {
+            return modbus_exceptionResponse(buffer, 0x03);
+        }
+    }
+    buffer[2] = quantity * 2;
+    modbus_stream.addr = addr;
+    modbus_stream.quantity = quantity;
+    return 3;
+}
+
+// called by the framing layer after the response in the frame buffer is encoded and again on
+// GLOBAL_EVENT_UART1_TX, values are sent only as long as they fit into the UART1 transmit buffer
+// put() encodes and sends one byte (including checksum calculation)
+// size: transmit buffer bytes needed for one value and the end of the frame
+// returns 1 if all values are sent, the framing layer sends the end of the frame then
+uint8_t modbus_streamResponse (void (*put)(uint8_t b), uint8_t size) {
+    while (modbus_stream.quantity > 0) {
+        if (sys_getUart1TxFree() < size) {
+            sys_waitUart1TxFree(GLOBAL_UART1_TXBUFSIZE / 2);
+            return 0;
+        }
+        uint16_t value = 0;
+        modbus_readHoldRegister(modbus_stream.addr++, &value);
+        modbus_stream.quantity--;
+        put(value >> 8);
+        put(value & 0xff);
+    }
+    return 1;
+}
+
+// 1 while values of a response are waiting for modbus_streamResponse()
+uint8_t modbus_isStreaming () {
+    return modbus_stream.quantity > 0;
+}
+
+// values: big endian register values
+uint8_t modbus_writeHoldRegisters (uint16_t addr, uint8_t quantity, uint8_t values[]) {
+    if ((addr & 0xfc00) == 0x1c00) {
+        return app_writePowerTable(addr - 0x1c00, quantity, values);
+    }
+    while (quantity-- > 0) {
+        uint16_t value = values[0] << 8 | values[1];
+        if (modbus_writeHoldRegister(addr++, value)) {
+            return 1;
+        }
+        values += 2;
+    }
+    return 0;
+}
+
+static uint32_t modbus_diff (int32_t a, int32_t b) {
+    return a > b ? a - b : b - a;
+}
+
+// called from main loop, so that a report is never sent between echo and response of a request
+// reports are sent only when framing is known (first valid request received)
+// and only when the frame fits into the UART1 transmit buffer, otherwise retried with the next tick
+static void modbus_checkReport () {
+    struct Modbus_Report *r = &modbus.report;
+    if (r->intervalMs == 0 || modbus.rxMode == MODBUS_MODE_AUTO) {
+        return;
+    }
+    uint8_t frameSize = modbus.rxMode == MODBUS_MODE_RTU ? MODBUS_RTU_FRAME_SIZE(MODBUS_REPORT_LENGTH)
+                                                         : MODBUS_ASCII_FRAME_SIZE(MODBUS_REPORT_LENGTH);
+    if (sys_getUart1TxFree() < frameSize) {
+        return;
+    }
+    uint32_t now = sys_getTimestamp();
+    uint16_t fault = app_getFault();
+    if (fault == r->fault) { // a latched or cleared fault is reported at once
+        if ((now - r->checkAt) < (uint32_t)MODBUS_REPORT_CHECK_MS * MODBUS_REPORT_TICKS_PER_MS) {
+            return;
+        }
+        r->checkAt = now;
+        if ((now - r->lastAt) < (uint32_t)MODBUS_REPORT_MIN_MS * MODBUS_REPORT_TICKS_PER_MS) {
+            return;
+        }
+    }
+    uint32_t dt = now - r->lastAt;
+    uint16_t sensor0Power = app_getSensor0Power();
+    uint16_t powerRamp = app_getPowerRamp();
+    int16_t  temp1 = app_getPt1000Temp1();
+    int16_t  temp2 = app_getPt1000Temp2();
+    uint8_t send = fault != r->fault || dt >= (uint32_t)r->intervalMs * MODBUS_REPORT_TICKS_PER_MS;
+    if (!send) {
+        // sensor0Power in 0.1W, a deadband of 0 reports every change
+        send = modbus_diff(sensor0Power, r->sensor0Power) > (uint32_t)r->powerDeadband * 10 ||
+               modbus_diff(powerRamp, r->powerRamp) > r->powerDeadband ||
+               modbus_diff(temp1, r->pt1000Temp[0]) > r->tempDeadband ||
+               modbus_diff(temp2, r->pt1000Temp[1]) > r->tempDeadband;
+    }
+    if (!send) {
+        return;
+    }
+    uint8_t buffer[MODBUS_REPORT_LENGTH];
+    buffer[0] = GLOBAL_MODBUS_DEVICEADDR;
+    buffer[1] = MODBUS_FC_REPORT;
+    uint8_t length = modbus_readHoldRegisters(buffer, 0, MODBUS_REPORT_QUANTITY);
+    if (length == 0) {
+        return;
+    }
+    if (modbus.rxMode == MODBUS_MODE_RTU) {
+        modbusRtu_sendFrame(buffer, length);
+    } else {
+        modbusAscii_sendFrame(buffer, length);
+    }
+    r->cnt++;
+    r->lastAt = now;
+    r->sensor0Power = sensor0Power;
+    r->powerRamp = powerRamp;
+    r->pt1000Temp[0] = temp1;
+    r->pt1000Temp[1] = temp2;
+    r->fault = fault;
+}
+
+uint16_t modbus_getReportInterval () {
+    return modbus.report.intervalMs;
+}
+
+uint8_t modbus_setReportInterval (uint16_t ms) {
+    if (ms > 0 && ms < MODBUS_REPORT_MIN_MS) {
+        return 1;
+    }
+    modbus.report.intervalMs = ms;
+    modbus.report.lastAt = sys_getTimestamp() - (uint32_t)ms * MODBUS_REPORT_TICKS_PER_MS; // report as soon as possible
+    return 0;
+}
+
+uint16_t modbus_getReportPowerDeadband () {
+    return modbus.report.powerDeadband;
+}
+
+uint8_t modbus_setReportPowerDeadband (uint16_t watts) {
+    if (watts > 2000) {
+        return 1;
+    }
+    modbus.report.powerDeadband = watts;
+    return 0;
+}
+
+uint16_t modbus_getReportTempDeadband () {
+    return modbus.report.tempDeadband;
+}
+
+uint8_t modbus_setReportTempDeadband (uint16_t centiCelsius) {
+    modbus.report.tempDeadband = centiCelsius;
+    return 0;
+}
+
+// response of FC 0x18: byte count (2 bytes), FIFO count (2 bytes), max. 31 registers,
+// only complete samples are sent, they are removed from the fifo
+static uint8_t modbus_readSampleFifo (uint8_t buffer[], uint8_t size) {
+    uint8_t max = size < 6 ? 0 : (size - 6) / 2 / APP_SAMPLE_WORDS;
+    if (max > 31 / APP_SAMPLE_WORDS) {
+        max = 31 / APP_SAMPLE_WORDS;
+    }
+    uint8_t i = 6;
+    struct App_Sample s;
+    while (max-- > 0 && app_popSample(&s) == 0) {
+        buffer[i++] = s.current >> 8;
+        buffer[i++] = s.current & 0xff;
+        buffer[i++] = s.setpoint >> 8;
+        buffer[i++] = s.setpoint & 0xff;
+        buffer[i++] = s.seq;
+        buffer[i++] = s.sensor0Cnt;
+    }
+    uint8_t words = (i - 6) / 2;
+    buffer[2] = 0;
+    buffer[3] = 2 + 2 * words;
+    buffer[4] = 0;
+    buffer[5] = words;
+    return i;
+}
+
+// buffer: request frame without LRC/CRC (address, function code, data)
+// returns length of response in buffer (0 -> no response)
+uint8_t modbus_handleRequest (uint8_t buffer[], uint8_t length, uint8_t size) {
+    if (length < 2 || buffer[0] != GLOBAL_MODBUS_DEVICEADDR) {
+        return 0;
+    }
+    modbus.uart1.confirmed = 1;
+    modbus.uart1.frameAt = sys_getUptimeMs();
+    modbus_stream.quantity = 0;
+    modbus_snapshot.src = NULL;
+    uint16_t w1 = buffer[2] << 8 | buffer[3];
+    uint16_t w2 = buffer[4] << 8 | buffer[5];
+    switch (buffer[1]) {
+        case 0x03: {
+            if (length < 6 || w2 < 1 || w2 > 0x7d) {
+                return modbus_exceptionResponse(buffer, 0x03);
+            }
+            return modbus_readResponse(buffer, w1, w2, size);
+        }
+
+        case 0x06: {
+            if (length < 6) {
+                return modbus_exceptionResponse(buffer, 0x03);
+            }
+            if (modbus_writeHoldRegister(w1, w2)) {
+                return modbus_exceptionResponse(buffer, 0x02);
+            }
+            return 6;
+        }
+
+        case 0x10: { // write multiple registers
+            if (length < 7 || w2 < 1 || w2 > 0x7b || buffer[6] != 2 * w2 || length < 7 + 2 * w2) {
+                return modbus_exceptionResponse(buffer, 0x03);
+            }
+            if (modbus_writeHoldRegisters(w1, w2, &buffer[7])) {
+                return modbus_exceptionResponse(buffer, 0x02);
+            }
+            return 6;
+        }
+
+        case 0x17: { // read/write multiple registers, write is done before read
+            if (length < 11) {
+                return modbus_exceptionResponse(buffer, 0x03);
+            }
+            uint16_t wAddr = buffer[6] << 8 | buffer[7];
+            uint16_t wQuantity = buffer[8] << 8 | buffer[9];
+            if (w2 < 1 || w2 > 0x7d ||
+                wQuantity < 1 || wQuantity > 0x79 || buffer[10] != 2 * wQuantity || length < 11 + 2 * wQuantity) {
+                return modbus_exceptionResponse(buffer, 0x03);
+            }
+            if (modbus_writeHoldRegisters(wAddr, wQuantity, &buffer[11])) {
+                return modbus_exceptionResponse(buffer, 0x02);
+            }
+            return modbus_readResponse(buffer, w1, w2, size);
+        }
+
+        case 0x18: { // read FIFO queue, sample fifo of app (FIFO pointer address MODBUS_REGISTER_SAMPLEFIFO)
+            if (length < 4) {
+                return modbus_exceptionResponse(buffer, 0x03);
+            }
+            if (w1 != MODBUS_REGISTER_SAMPLEFIFO) {
+                return modbus_exceptionResponse(buffer, 0x02);
+            }
+            return modbus_readSampleFifo(buffer, size);
+        }
+
+        default: {
+            return modbus_exceptionResponse(buffer, 0x01);
+        }
+    }
 }
 
 uint8_t modbus_readInputRegister (uint16_t addr, uint16_t value) {
@@ -24,9 +432,60 @@ uint8_t modbus_readInputRegister (uint16_t addr, uint16_t value) {
 }
 
 
-uint8_t modbus_readHoldRegister (uint16_t addr, uint16_t *value) {
-    static uint32_t sensor0Cnt = 0;
+uint16_t modbus_getMode () {
+    return modbus.mode;
+}
 
+// latches the counter, so that the low word fits to the high word
+uint16_t modbus_getSensor0CntHigh () {
+    uint8_t sreg = sys_enterCritical();
+    modbus_sensor0Cnt = app.sensor0Cnt;
+    sys_leaveCritical(sreg);
+    return modbus_sensor0Cnt >> 16;
+}
+
+uint16_t modbus_getSensor0CntLow () {
+    return modbus_sensor0Cnt & 0xffff;
+}
+
+// latches the uptime, so that the low word fits to the high word
+uint16_t modbus_getUptimeHigh () {
+    modbus_uptimeMs = sys_getUptimeMs();
+    return modbus_uptimeMs >> 16;
+}
+
+uint16_t modbus_getUptimeLow () {
+    return modbus_uptimeMs & 0xffff;
+}
+
+// word index < (length + 1) / 2 of debug window struct p with length bytes
+// the last word of an odd sized struct is padded with 0, no byte behind the struct is read
+static uint16_t modbus_readSnapshot (const uint16_t *p, uint16_t index, uint16_t length) {
+    if (modbus_snapshot.src != p || index < modbus_snapshot.first || index >= modbus_snapshot.first + modbus_snapshot.count) {
+        uint16_t words = (length + 1) / 2;
+        uint8_t count = words - index < GLOBAL_MODBUS_SNAPSHOT_WORDS ? words - index : GLOBAL_MODBUS_SNAPSHOT_WORDS;
+        uint16_t bytes = length - 2 * index < count * 2 ? length - 2 * index : count * 2;
+        modbus_snapshot.word[count - 1] = 0;
+        uint8_t sreg = sys_enterCritical();
+        memcpy(modbus_snapshot.word, &p[index], bytes);
+        sys_leaveCritical(sreg);
+        modbus_snapshot.src = p;
+        modbus_snapshot.first = index;
+        modbus_snapshot.count = count;
+    }
+    return modbus_snapshot.word[index - modbus_snapshot.first];
+}
+
+// value NULL: only checks if the register can be read (getters are not called)
+uint8_t modbus_readHoldRegister (uint16_t addr, uint16_t *value) {
+    if ((addr & 0xfc00) == 0x1c00) { // power table, power [W] at 6, 7, ... 20mA
+        uint16_t watts;
+        uint8_t rv = app_getPowerTable(addr - 0x1c00, &watts);
+        if (value != NULL) {
+            *value = watts;
+        }
+        return rv;
+    }
     if (addr >= 1024) {
         uint16_t *p = NULL;
         uint16_t length = 0, lengthErr = 0;
@@ -35,39 +494,50 @@ uint8_t modbus_readHoldRegister (uint16_t addr, uint16_t *value) {
             case 0x08: p = (uint16_t *)&sys; length = sizeof(sys); lengthErr = sizeof(sys.err); addr -= 0x0800; break;
             case 0x0c: p = (uint16_t *)&modbus; length = sizeof(modbus); lengthErr = sizeof(modbus.err); addr -= 0x0c00; break;
             case 0x10: p = (uint16_t *)&modbus_ascii; length = sizeof(modbus_ascii); lengthErr = sizeof(modbus_ascii.err); addr -= 0x1000; break;
+            case 0x14: p = (uint16_t *)&modbus_rtu; length = sizeof(modbus_rtu); lengthErr = sizeof(modbus_rtu.err); addr -= 0x1400; break;
+            case 0x18: p = (uint16_t *)&sys_taskTimes; length = sizeof(sys_taskTimes); lengthErr = 0; addr -= 0x1800; break;
         }
-        if (length > 0) {
-            if (addr == 0) {
-                *value = length;
-            } else if (addr == 1) {
-                *value = lengthErr;
-            } else if (addr < length) {
-                *value  = p[addr - 2];
-            } else {
-                return 1;
-            }
+        if (length == 0) { // no debug window (0x2000 ...)
+            return 1;
+        }
+        if (addr >= (length + 1) / 2 + 2) { // length and lengthErr, then the struct (length in bytes)
+            return 1;
+        } else if (value == NULL) {
+            return 0;
+        } else if (addr == 0) {
+            *value = length;
+        } else if (addr == 1) {
+            *value = lengthErr;
+        } else {
+            *value = modbus_readSnapshot(p, addr - 2, length);
         }
         return 0;
     }
 
-    switch (addr) {
-        case 0: *value = app_getSetpoint4To20mA(); break;
-        case 1: *value = app_getCurr4To20mA(); break;
-        case 2: *value = app.sensor0Time; break;
-        case 3: {
-            sys_cli();
-            sensor0Cnt = app.sensor0Cnt;
-            sys_sei();
-            *value = sensor0Cnt >> 16;
-            break;
-        }
-        case 4: *value = sensor0Cnt & 0xffff; break;
-        default: return 1;
+    if (addr >= MODBUS_REGISTER_SIZE) {
+        return 1;
+    }
+    uint16_t (*get)() = pgm_read_ptr(&modbus_register[addr].get);
+    if (get == NULL) {
+        return 1;
+    }
+    if (value != NULL) {
+        *value = get();
     }
     return 0;
 }
 
 uint8_t modbus_writeHoldRegister (uint16_t addr, uint16_t value) {
+    if ((addr & 0xfc00) == 0x1800) { // task times, any write to 0x1802 resets the statistics
+        if (addr != 0x1802) {
+            return 1;
+        }
+        sys_clearTaskTimes();
+        return 0;
+    }
+    if ((addr & 0xfc00) == 0x1c00) {
+        return app_setPowerTable(addr - 0x1c00, value);
+    }
     if (addr >= 1024) {
         uint16_t *p = NULL;
         uint16_t size = 0, lengthErr = 0;;
@@ -76,6 +546,7 @@ uint8_t modbus_writeHoldRegister (uint16_t addr, uint16_t value) {
             case 0x08: p = (uint16_t *)&sys; size = sizeof(sys); lengthErr = sizeof(sys.err); addr -= 0x0800; break;
             case 0x0c: p = (uint16_t *)&modbus; size = sizeof(modbus); lengthErr = sizeof(modbus.err); addr -= 0x0c00; break;
             case 0x10: p = (uint16_t *)&modbus_ascii; size = sizeof(modbus_ascii); lengthErr = sizeof(modbus_ascii.err); addr -= 0x1000; break;
+            case 0x14: p = (uint16_t *)&modbus_rtu; size = sizeof(modbus_rtu); lengthErr = sizeof(modbus_rtu.err); addr -= 0x1400; break;
         }
         if (size > 0) {
             if (addr < 2) {
@@ -91,9 +562,13 @@ uint8_t modbus_writeHoldRegister (uint16_t addr, uint16_t value) {
         }
         return 1;
     }
-    switch (addr) {
-        case 0: return app_setSetpoint4To20mA(value);
+    if (addr >= MODBUS_REGISTER_SIZE) {
+        return 1;
     }
-
+    uint8_t (*set)(uint16_t) = pgm_read_ptr(&modbus_register[addr].set);
+    if (set == NULL) {
+        return 1;
+    }
+    return set(value);
 }
 
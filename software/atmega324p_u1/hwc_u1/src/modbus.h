@@ -1,14 +1,49 @@
 #ifndef MODBUS_H_
 #define MODBUS_H_
 
+#define MODBUS_MODE_AUTO  0
+#define MODBUS_MODE_ASCII 1
+#define MODBUS_MODE_RTU   2
+
 struct Modbus_ErrorCnt { // size word aligned !
     uint16_t error_u16;
+    uint16_t uart1Fallback_u16;  // UART1 back to GLOBAL_UART1_BITRATE (not confirmed or idle)
+};
+
+#define MODBUS_FC_REPORT    0x41  // unsolicited report (user defined function code)
+#define MODBUS_REPORT_MIN_MS  100  // min. time between two reports
+
+// change of value reports, sent without request if a value moves past its deadband
+// or intervalMs has elapsed since the last report
+struct Modbus_Report {
+    uint16_t intervalMs;     // 0 = reports off
+    uint16_t powerDeadband;  // [W] for sensor0Power and powerRamp
+    uint16_t tempDeadband;   // [0.01°C] for pt1000Temp1/2
+    uint16_t cnt;
+    uint16_t sensor0Power;   // last reported values
+    uint16_t powerRamp;
+    int16_t  pt1000Temp[2];
+    uint16_t fault;          // APP_FAULT_... bits
+    uint32_t lastAt;         // timestamp of last report
+    uint32_t checkAt;        // timestamp of last deadband check
+};
+
+// UART1 bit rate [100 bit/s], changed by master (see modbus_setUart1Bitrate)
+struct Modbus_Uart1 {
+    uint16_t bitrate;    // in use
+    uint16_t pending;    // switched to after the response is sent, 0 = no change
+    uint8_t  confirmed;  // valid frame received with bitrate
+    uint32_t frameAt;    // uptime [ms] of last valid frame or bit rate change
 };
 
 struct Modbus {
     uint8_t version;
     uint8_t debugLevel;
     struct Modbus_ErrorCnt err;
+    uint8_t mode;     // configured framing (MODBUS_MODE_...)
+    uint8_t rxMode;   // framing in use, MODBUS_MODE_AUTO until first valid frame
+    struct Modbus_Report report;
+    struct Modbus_Uart1 uart1;
 };
 
 extern struct Modbus modbus;
@@ -17,8 +52,27 @@ extern struct Modbus modbus;
 void modbus_init();
 void modbus_main ();
 
+void    modbus_handleUart1Byte (uint8_t b);
+uint8_t modbus_handleRequest (uint8_t buffer[], uint8_t length, uint8_t size);
+uint8_t modbus_streamResponse (void (*put)(uint8_t b), uint8_t size);
+uint8_t modbus_isStreaming ();
+uint8_t modbus_setMode (uint16_t mode);
+uint16_t modbus_getMode ();
+uint16_t modbus_getSensor0CntHigh ();
+uint16_t modbus_getSensor0CntLow ();
+uint16_t modbus_getUptimeHigh ();
+uint16_t modbus_getUptimeLow ();
+uint16_t modbus_getReportInterval ();
+uint8_t  modbus_setReportInterval (uint16_t ms);
+uint16_t modbus_getReportPowerDeadband ();
+uint8_t  modbus_setReportPowerDeadband (uint16_t watts);
+uint16_t modbus_getReportTempDeadband ();
+uint8_t  modbus_setReportTempDeadband (uint16_t centiCelsius);
+uint16_t modbus_getUart1Bitrate ();
+uint8_t  modbus_setUart1Bitrate (uint16_t bitrate);
+
 uint8_t modbus_readInputRegister (uint16_t addr, uint16_t value);
 uint8_t modbus_readHoldRegister (uint16_t addr, uint16_t *value);
 uint8_t modbus_writeHoldRegister (uint16_t addr, uint16_t value);
 
-#endif // MODBUS_H_
\ No newline at end of file
+#endif // MODBUS_H_
@@ -6,11 +6,16 @@
 #include "modbus.h"
 #include "global.h"
 #include "sys.h"
+#include "log.h"
 
 struct ModbusAscii modbus_ascii;
 #define ma modbus_ascii
 
-void modbusAscii_handleFrame ();
+void modbusAscii_handleFrame (uint8_t buffer[], uint8_t length);
+static void modbusAscii_sendStream (void);
+static uint8_t modbusAscii_txSize (uint8_t length);
+
+static uint8_t modbusAscii_txStream; // response is streamed, end of frame not sent yet
 
 void modbusAscii_init () {
     memset((void *)&modbus_ascii, 0, sizeof(modbus_ascii));
@@ -24,22 +29,45 @@ void modbusAscii_main () {
     uint8_t errDetected = 0;
     for (uint8_t i = 0; i < sizeof(ma.err); i++) {
         if (*p++ != 0) {
-            sys_setEvent(GLOBAL_EVENT_MODBUS_ASCII_ERROR);
             errDetected = 1;
             break;
         }
     }
+    if (errDetected && modbus.rxMode != MODBUS_MODE_RTU) {
+        sys_setEvent(GLOBAL_EVENT_MODBUS_ERROR);
+    }
     if (sys_isSw2On() && errDetected) {
         memset((void *)&modbus_ascii.err, 0, sizeof(modbus_ascii.err));
     }
-    if (sys_isEventPending(GLOBAL_EVENT_MODBUS_BUSY)) {
-        modbusAscii_handleFrame();
-        ma.bIndex = 0;
-        sys_clearEvent(GLOBAL_EVENT_MODBUS_BUSY);
-
+    if (modbusAscii_txStream) {
+        modbusAscii_sendStream();
+        if (modbusAscii_txStream) {
+            return; // received frames wait for the end of the response
+        }
+    }
+    if (ma.length[ma.mainBuffer] > 0) {
+        uint8_t txSize = modbusAscii_txSize(ma.length[ma.mainBuffer]);
+        if (sys_getUart1TxFree() < txSize) {
+            sys_waitUart1TxFree(txSize); // previous response still in transmit buffer
+            return;
+        }
+        modbusAscii_handleFrame(ma.buffer[ma.mainBuffer], ma.length[ma.mainBuffer]);
+        sys_updateTaskTime(SYS_TASKTIME_MODBUS_LATENCY, ma.rxTimer[ma.mainBuffer]);
+        ma.length[ma.mainBuffer] = 0; // release buffer for receiver
+        ma.mainBuffer ^= 1;
+        if (ma.length[ma.mainBuffer] > 0) {
+            sys_setEvent(GLOBAL_EVENT_MODBUS_RX); // second buffer filled meanwhile
+        }
     }
 }
 
+// resets the frame in reception, frames waiting for modbusAscii_main() are kept
+void modbusAscii_reset () {
+    ma.bIndex = 0;
+    ma.lrc = 0;
+    ma.rxStatus = 0;
+}
+
 
 int8_t modbusAscii_hex2nibble(uint8_t hex) {
     if (hex >= '0' && hex <= '9') {
@@ -51,157 +79,149 @@ int8_t modbusAscii_hex2nibble(uint8_t hex) {
     }
 }
 
-int8_t modbusAscii_hexBuffer2BinBuffer(uint8_t from[], uint8_t to[], int16_t size) {
-    int8_t rv = 0;
-    while (size > 0) {
-        int8_t high = modbusAscii_hex2nibble(*from++);
-        int8_t low = modbusAscii_hex2nibble(*from++);
-        if (high < 0 || low < 0) {
-            return -1;
-        }
-        *to++ = (high << 4) | low;
-        rv++;
-        size -= 2;
+static uint8_t modbusAscii_txLrc;
+
+static void modbusAscii_sendByte (uint8_t b) {
+    modbusAscii_txLrc += b;
+    fprintf(sys.fOutModbus, "%02X", b);
+}
+
+// sends the values of a large read response as far as they fit into the transmit buffer,
+// continued by modbusAscii_main() on GLOBAL_EVENT_UART1_TX, the main loop does not wait
+static void modbusAscii_sendStream (void) {
+    modbusAscii_txStream = !modbus_streamResponse(modbusAscii_sendByte, MODBUS_ASCII_STREAM_SIZE);
+    if (!modbusAscii_txStream) {
+        fprintf(sys.fOutModbus, "%02X\r\n", (uint8_t)( -((signed char)modbusAscii_txLrc)));
     }
-    return rv;
 }
 
-void modbusAscii_sendResponse (uint8_t length) {
-    uint8_t lrc = 0;
+// stream: values of a large read response follow the bytes of buffer (modbus_streamResponse())
+static void modbusAscii_send (uint8_t buffer[], uint8_t length, uint8_t stream) {
+    modbusAscii_txLrc = 0;
     fputc(':', sys.fOutModbus);
-    uint8_t *p = &ma.buffer[0];
-    uint8_t size = length;
-    while (size-- > 0) {
-        lrc += *p;
-        fprintf(sys.fOutModbus, "%02X", *p++);
+    while (length-- > 0) {
+        modbusAscii_sendByte(*buffer++);
     }
+    if (stream) {
+        modbusAscii_sendStream();
+    } else {
+        fprintf(sys.fOutModbus, "%02X\r\n", (uint8_t)( -((signed char)modbusAscii_txLrc)));
+    }
+}
 
-    fprintf(sys.fOutModbus, "%02X\r\n", (uint8_t)( -((signed char)lrc)));
+void modbusAscii_sendFrame (uint8_t buffer[], uint8_t length) {
+    modbusAscii_send(buffer, length, 0);
+}
+
+void modbusAscii_sendResponse (uint8_t buffer[], uint8_t length) {
+    modbusAscii_send(buffer, length, 1);
     if (ma.debugLevel >= GLOBAL_DEBUG_LEVEL_FINE) {
-        printf("Response :");
-        for (uint8_t i = 0; i < length; i++) { printf("%02X", ma.buffer[i]); }
-         printf("%02X", lrc);
-        printf("\\r\\n\r\n");
+        sys_log(LOG_MODBUS_ASCII_RESPONSE, buffer, length);
     }
 
 }
 
-void modbusAscii_sendErrorResponse (uint8_t exceptionCode) {
-    ma.buffer[1] |= 0x80;
-    ma.buffer[2] |= exceptionCode;
-    return modbusAscii_sendResponse(3);
+// transmit buffer bytes needed for a request (length with LRC): echo and largest response,
+// limited to the buffer size (modbusAscii_handleFrame() shortens the response then)
+static uint8_t modbusAscii_txSize (uint8_t length) {
+    uint16_t rv = MODBUS_ASCII_FRAME_SIZE(GLOBAL_MODBUS_ASCII_BUFSIZE);
+    #if GLOBAL_MODBUS_ECHOREQUEST != 0
+        rv += MODBUS_ASCII_FRAME_SIZE(length - 1);
+    #endif
+    return rv > GLOBAL_UART1_TXBUFSIZE - 1 ? GLOBAL_UART1_TXBUFSIZE - 1 : rv; // ring keeps one byte free
 }
 
-
-void modbusAscii_handleFrame () {
-    sys_setEvent(GLOBAL_EVENT_MODBUS_ASCII_FRAME);
-    int8_t size = modbusAscii_hexBuffer2BinBuffer(&ma.buffer[1], &ma.buffer[0], ma.bIndex - 1);
+// length: frame size including LRC (already verified by modbusAscii_handleModbusAsciiByte())
+// the response is limited to the space left in the transmit buffer, so sys_uart1_putch() never waits
+// (larger reads are streamed, FC 0x18 returns less samples)
+void modbusAscii_handleFrame (uint8_t buffer[], uint8_t length) {
+    sys_setEvent(GLOBAL_EVENT_MODBUS_FRAME);
+    ma.frameCnt++;
+    uint8_t size = length - 1; // without LRC
     if (ma.debugLevel >= GLOBAL_DEBUG_LEVEL_FINE) {
-        printf("Request (%02x) :", size);
-        for (uint8_t i = 0; i < size; i++) { printf("%02X", ma.buffer[i]); }
-        printf("\\r\\n\r\n");
-    }
-
-    uint8_t lrc = 0 ;
-    for (uint8_t i = 0; i < size - 1; i++) {
-        lrc += ma.buffer[i];
-    }
-    lrc = (uint8_t) ( -((signed char)lrc) );
-
-    if (lrc == ma.buffer[size - 1]) {
-        if (ma.buffer[0] == GLOBAL_MODBUS_DEVICEADDR) {
-            uint16_t w1 = ma.buffer[2] << 8 | ma.buffer[3];
-            uint16_t w2 = ma.buffer[4] << 8 | ma.buffer[5];
-            switch (ma.buffer[1]) {
-                case 0x03: {
-                    if (w2 < 1 || w2 > 0x7d || w2 > (GLOBAL_MODBUS_ASCII_BUFSIZE - 2)) {
-                        return modbusAscii_sendErrorResponse(0x03);
-                    } else {
-                        uint16_t addr = w1;
-                        uint8_t size = w2;
-                        uint16_t i = 2;
-                        ma.buffer[i++] = size * 2;
-                        while (size-- > 0) {
-                            uint16_t value;
-                            if (modbus_readHoldRegister(addr++, &value)) {
-                                return modbusAscii_sendErrorResponse(0x03);
-                            }
-                            ma.buffer[i++] = value >> 8;
-                            ma.buffer[i++] = value & 0xff;
-                        }                        
-                        return modbusAscii_sendResponse(i);
-                    }
-                    break;
-                }
-
-                case 0x06: {
-                    uint16_t addr = w1;
-                    uint16_t value = w2;
-                    if (modbus_writeHoldRegister(addr, value)) {
-                        return modbusAscii_sendErrorResponse(0x02);
-                    }
-                    return modbusAscii_sendResponse(6);
-                }
-
-                default: {
-                    return modbusAscii_sendErrorResponse(0x01);
-                    
-                }
-            }
-        }
-
-    } else {
-        sys_inc8BitCnt(&ma.err.lrcError);
-        if (ma.debugLevel >= GLOBAL_DEBUG_LEVEL_WARN) {
-            printf("LRC %02X Error (expect %02X)\r\n", ma.buffer[size - 1], lrc);
-        }
+        sys_log(LOG_MODBUS_ASCII_REQUEST, buffer, size);
+    }
+    #if GLOBAL_MODBUS_ECHOREQUEST != 0
+        modbusAscii_sendFrame(buffer, size);
+    #endif
+    uint8_t free = sys_getUart1TxFree();
+    uint8_t max = GLOBAL_MODBUS_ASCII_BUFSIZE;
+    if (free < MODBUS_ASCII_FRAME_SIZE(max)) {
+        max = (free - 5) / 2;
+    }
+    size = modbus_handleRequest(buffer, size, max);
+    if (size > 0) {
+        modbusAscii_sendResponse(buffer, size);
     }
 }
 
+// called from USART1_RX_vect
+// hex characters are decoded into ma.buffer and the LRC is summed up on the fly,
+// so the frame is verified and ready for modbus_handleRequest() when LF is received
 void modbusAscii_handleModbusAsciiByte (char c) {
-    static uint8_t isLastByteCR = 0;
-    
-    if (sys_isEventPending(GLOBAL_EVENT_MODBUS_BUSY)) {
+    if (ma.length[ma.rxBuffer] > 0) { // both buffers in use
         sys_inc8BitCnt(&ma.err.byteWhileBusy);
         return;
     }
 
-    if (ma.bIndex == 0 && c != ':') {
+    if (c == ':') {
+        if (ma.rxStatus & MODBUS_ASCII_RXSTATUS_FRAME) {
+            sys_inc8BitCnt(&ma.err.invalidFrame);
+        }
+        ma.bIndex = 0;
+        ma.lrc = 0;
+        ma.rxStatus = MODBUS_ASCII_RXSTATUS_FRAME;
+        return;
+    }
+
+    if (!(ma.rxStatus & MODBUS_ASCII_RXSTATUS_FRAME)) {
         if (ma.frameCnt > 0) {
             sys_inc16BitCnt(&ma.err.invalidUartByte);
         }
+        return;
+    }
 
-    } else if (c == ':') {
-        if (ma.bIndex > 0) {
+    if (c == '\n') {
+        if (!(ma.rxStatus & MODBUS_ASCII_RXSTATUS_CR) || (ma.rxStatus & MODBUS_ASCII_RXSTATUS_NIBBLE) || ma.bIndex < 2) {
             sys_inc8BitCnt(&ma.err.invalidFrame);
-            ma.bIndex = 0;
-        }
-        isLastByteCR = 0;
-
-    } else if (c == '\n') {
-        if (isLastByteCR && ma.bIndex % 2 == 1) {
-            sys_setEvent(GLOBAL_EVENT_MODBUS_BUSY);
+        } else if (ma.rxStatus & MODBUS_ASCII_RXSTATUS_OVERFLOW) {
+            sys_inc8BitCnt(&ma.err.frameOverflow);
+        } else if (ma.lrc != 0) { // sum of all bytes including LRC must be 0
+            sys_inc8BitCnt(&ma.err.lrcError);
         } else {
-            sys_inc8BitCnt(&ma.err.invalidFrame);
-            ma.bIndex = 0;
+            modbus.rxMode = MODBUS_MODE_ASCII;
+            ma.length[ma.rxBuffer] = ma.bIndex;
+            ma.rxTimer[ma.rxBuffer] = sys_getTaskTimer();
+            ma.rxBuffer ^= 1;
+            sys_setEvent(GLOBAL_EVENT_MODBUS_RX);
         }
-        isLastByteCR = 0;
+        modbusAscii_reset();
         return;
+    }
 
-    } else if (c == '\r') {
-        isLastByteCR = 1;
+    if (c == '\r') {
+        ma.rxStatus |= MODBUS_ASCII_RXSTATUS_CR;
         return;
+    }
 
-    } else if (!(c >= '0' || c <= '1') && !(c >= 'A' && c <= 'F')) {
+    int8_t nibble = modbusAscii_hex2nibble(c);
+    if (nibble < 0 || (ma.rxStatus & MODBUS_ASCII_RXSTATUS_CR)) {
         sys_inc16BitCnt(&ma.err.invalidUartByte);
-        ma.bIndex = 0;
+        modbusAscii_reset();
         return;
     }
 
-    if (ma.bIndex >= sizeof ma.buffer) {
-        sys_inc8BitCnt(&ma.err.frameOverflow);
+    if (!(ma.rxStatus & MODBUS_ASCII_RXSTATUS_NIBBLE)) {
+        ma.highNibble = nibble;
+        ma.rxStatus |= MODBUS_ASCII_RXSTATUS_NIBBLE;
         return;
     }
-
-    ma.buffer[ma.bIndex++] = c;
-}
\ No newline at end of file
+    ma.rxStatus &= ~MODBUS_ASCII_RXSTATUS_NIBBLE;
+    if (ma.bIndex >= GLOBAL_MODBUS_ASCII_BUFSIZE) {
+        ma.rxStatus |= MODBUS_ASCII_RXSTATUS_OVERFLOW;
+        return;
+    }
+    uint8_t b = (ma.highNibble << 4) | nibble;
+    ma.buffer[ma.rxBuffer][ma.bIndex++] = b;
+    ma.lrc += b;
+}
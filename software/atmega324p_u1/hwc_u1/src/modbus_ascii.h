@@ -4,6 +4,20 @@
 #include <stdint.h>
 #include "global.h"
 
+#define MODBUS_ASCII_RXSTATUS_FRAME    0x01  // ':' received
+#define MODBUS_ASCII_RXSTATUS_NIBBLE   0x02  // high nibble received, waiting for low nibble
+#define MODBUS_ASCII_RXSTATUS_CR       0x04
+#define MODBUS_ASCII_RXSTATUS_OVERFLOW 0x08
+
+#define MODBUS_ASCII_STREAM_SIZE       8     // one streamed register value (4 characters) and LRC, CR, LF
+#define MODBUS_ASCII_FRAME_SIZE(length) (2 * (length) + 5)  // ':', hex characters, LRC, CR, LF
+
+// echo of the largest request and the shortest response (exception or streamed read) must fit
+// (the ring buffer keeps one byte free)
+#if MODBUS_ASCII_FRAME_SIZE(GLOBAL_MODBUS_ASCII_BUFSIZE - 1) + MODBUS_ASCII_FRAME_SIZE(3) > GLOBAL_UART1_TXBUFSIZE - 1
+#error "UART1 transmit buffer too small for Modbus ASCII"
+#endif
+
 struct ModbusAsciiErrorCnt { // size word aligned !
     uint16_t invalidUartByte;
     uint8_t invalidFrame;
@@ -17,8 +31,15 @@ struct ModbusAscii {
     uint8_t version;
     uint8_t debugLevel;
     struct ModbusAsciiErrorCnt err;
-    uint8_t buffer[GLOBAL_MODBUS_ASCII_BUFSIZE];
+    uint8_t buffer[2][GLOBAL_MODBUS_ASCII_BUFSIZE];  // binary frames (hex decoded), ping-pong
+    uint8_t length[2];   // > 0 -> frame (with LRC) waiting for modbusAscii_main()
+    uint16_t rxTimer[2]; // sys_getTaskTimer() at end of frame
+    uint8_t rxBuffer;    // buffer used by receiver
+    uint8_t mainBuffer;  // next buffer handled by modbusAscii_main()
     uint8_t bIndex;
+    uint8_t rxStatus;
+    uint8_t highNibble;
+    uint8_t lrc;
     uint16_t frameCnt;
 };
 
@@ -26,6 +47,8 @@ extern struct ModbusAscii modbus_ascii;
 
 void modbusAscii_init();
 void modbusAscii_main ();
+void modbusAscii_reset ();
 void modbusAscii_handleModbusAsciiByte (char c);
+void modbusAscii_sendFrame (uint8_t buffer[], uint8_t length);
 
 #endif // MODBUS_ASCII_H_
\ No newline at end of file
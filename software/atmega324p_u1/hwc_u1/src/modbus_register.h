@@ -0,0 +1,74 @@
+// generated by modbus_register.js from modbus_register.json, do not edit
+
+#ifndef MODBUS_REGISTER_H_
+#define MODBUS_REGISTER_H_
+
+#define MODBUS_REGISTER_SETPOINT4TO20MA           0 // setpoint of 4-20mA output
+#define MODBUS_REGISTER_CURRENT4TO20MA            1 // measured current of 4-20mA output
+#define MODBUS_REGISTER_SENSOR0TIME               2 // time between the last two S0 pulses, 0xffff if no pulse
+#define MODBUS_REGISTER_SENSOR0CNT                3 // S0 pulse counter, reading the high word latches the low word
+#define MODBUS_REGISTER_MODBUSMODE                5 // Modbus framing, 0=auto, 1=ASCII, 2=RTU
+#define MODBUS_REGISTER_ADCRAW                    6 // 4-20mA input, last ADC conversion (10 bit)
+#define MODBUS_REGISTER_ADCVALUE                  7 // 4-20mA input, oversampled and decimated (12/13 bit)
+#define MODBUS_REGISTER_ADCFILTERED               8 // 4-20mA input, adcValue after IIR low pass
+#define MODBUS_REGISTER_ADCFILTERSHIFT            9 // IIR low pass y += (x - y) / 2^n, 0..8, 0 = off
+#define MODBUS_REGISTER_PT1000TEMP1               10 // temperature of PT1000-1, 0x8000 if sensor open or shorted
+#define MODBUS_REGISTER_PT1000TEMP2               11 // temperature of PT1000-2, 0x8000 if sensor open or shorted
+#define MODBUS_REGISTER_SENSOR0POWER              12 // active power from S0 pulse timestamps, averaged over the last 10s
+#define MODBUS_REGISTER_CONTROL4TO20MA            13 // 4-20mA output, 0=open loop, 1=closed loop (PI), 2=closed loop saturated (read only)
+#define MODBUS_REGISTER_POWERSETPOINT             14 // power setpoint, converted by power table (0x1c00), 0xffff if setpoint4To20mA written
+#define MODBUS_REGISTER_POWERRAMP                 15 // power setpoint after slew rate limitation
+#define MODBUS_REGISTER_POWERSLEWUP               16 // max. increase of powerRamp, 0 = unlimited
+#define MODBUS_REGISTER_POWERSLEWDOWN             17 // max. decrease of powerRamp, 0 = unlimited
+#define MODBUS_REGISTER_SAMPLEDIVIDER             18 // sample fifo, one sample every n * 2ms (max. 255), 0 = off
+#define MODBUS_REGISTER_SAMPLEFIFO                19 // samples in fifo, FIFO pointer address for FC 0x18 (current, setpoint, seq/sensor0Cnt)
+#define MODBUS_REGISTER_SAMPLELOST                20 // samples not stored because fifo was full
+#define MODBUS_REGISTER_REPORTINTERVAL            21 // change of value reports (FC 0x41, registers 0..28), max. time between reports (>= 100), 0 = off
+#define MODBUS_REGISTER_REPORTPOWERDEADBAND       22 // report if sensor0Power or powerRamp moves more than this value
+#define MODBUS_REGISTER_REPORTTEMPDEADBAND        23 // report if pt1000Temp1 or pt1000Temp2 moves more than this value
+#define MODBUS_REGISTER_UPTIME                    24 // milliseconds since reset, reading the high word latches the low word
+#define MODBUS_REGISTER_ADCAT                     26 // uptime (low word) of last adcValue
+#define MODBUS_REGISTER_PT1000AT                  27 // uptime (low word) of ADC values used for pt1000Temp1/2
+#define MODBUS_REGISTER_SENSOR0PULSEAT            28 // uptime (low word) of last S0 pulse
+#define MODBUS_REGISTER_UART1BITRATE              29 // UART1 bit rate / 100 (1152, 5000, 7500, 15000), switched after the response, falls back to 1152 without valid frames
+#define MODBUS_REGISTER_OVERCURRENTTRIP           30 // trip level of 4-20mA output current (4..29mA), 0 = off, checked on every ADC conversion
+#define MODBUS_REGISTER_FAULT                     31 // latched faults, bit 0: over-current trip (PWM and SSRs off), write 0 to clear (sets 4-20mA setpoint to 0)
+#define MODBUS_REGISTER_SIZE                      32
+
+// R(addr, get, set) for each register word, set is NULL for read only registers
+#define MODBUS_REGISTER_TABLE(R) \
+    R(0, app_getSetpoint4To20mA, app_setSetpoint4To20mA) \
+    R(1, app_getCurr4To20mA, NULL) \
+    R(2, app_getSensor0Time, NULL) \
+    R(3, modbus_getSensor0CntHigh, NULL) \
+    R(4, modbus_getSensor0CntLow, NULL) \
+    R(5, modbus_getMode, modbus_setMode) \
+    R(6, sys_getAdcRaw, NULL) \
+    R(7, sys_getAdcValue, NULL) \
+    R(8, sys_getAdcFiltered, NULL) \
+    R(9, sys_getAdcFilterShift, sys_setAdcFilterShift) \
+    R(10, app_getPt1000Temp1, NULL) \
+    R(11, app_getPt1000Temp2, NULL) \
+    R(12, app_getSensor0Power, NULL) \
+    R(13, app_getControl4To20mA, app_setControl4To20mA) \
+    R(14, app_getPowerSetpoint, app_setPowerSetpoint) \
+    R(15, app_getPowerRamp, NULL) \
+    R(16, app_getPowerSlewUp, app_setPowerSlewUp) \
+    R(17, app_getPowerSlewDown, app_setPowerSlewDown) \
+    R(18, app_getSampleDivider, app_setSampleDivider) \
+    R(19, app_getSampleFifoCount, NULL) \
+    R(20, app_getSampleLost, NULL) \
+    R(21, modbus_getReportInterval, modbus_setReportInterval) \
+    R(22, modbus_getReportPowerDeadband, modbus_setReportPowerDeadband) \
+    R(23, modbus_getReportTempDeadband, modbus_setReportTempDeadband) \
+    R(24, modbus_getUptimeHigh, NULL) \
+    R(25, modbus_getUptimeLow, NULL) \
+    R(26, sys_getAdcAt, NULL) \
+    R(27, app_getPt1000At, NULL) \
+    R(28, app_getSensor0PulseMs, NULL) \
+    R(29, modbus_getUart1Bitrate, modbus_setUart1Bitrate) \
+    R(30, app_getOvercurrentTrip, app_setOvercurrentTrip) \
+    R(31, app_getFault, app_setFault) \
+    // end of MODBUS_REGISTER_TABLE
+
+#endif // MODBUS_REGISTER_H_
@@ -0,0 +1,198 @@
+#include <stdio.h>
+#include <string.h>
+#include <util/crc16.h>
+
+#include "modbus_rtu.h"
+#include "modbus.h"
+#include "global.h"
+#include "sys.h"
+#include "log.h"
+
+struct ModbusRtu modbus_rtu;
+#define mr modbus_rtu
+
+void modbusRtu_handleFrame (uint8_t buffer[], uint8_t length);
+static void modbusRtu_sendStream (void);
+
+static uint8_t modbusRtu_txStream; // response is streamed, CRC not sent yet
+
+void modbusRtu_init () {
+    memset((void *)&modbus_rtu, 0, sizeof(modbus_rtu));
+    mr.version = 1;
+    mr.debugLevel = GLOBAL_DEBUG_LEVEL_INFO;
+    mr.crc = 0xffff;
+    modbusRtu_setBitrate(GLOBAL_UART1_BITRATE);
+}
+
+void modbusRtu_main () {
+    uint8_t *p = (uint8_t *)&mr.err;
+    uint8_t errDetected = 0;
+    for (uint8_t i = 0; i < sizeof(mr.err); i++) {
+        if (*p++ != 0) {
+            errDetected = 1;
+            break;
+        }
+    }
+    if (errDetected && modbus.rxMode == MODBUS_MODE_RTU) {
+        sys_setEvent(GLOBAL_EVENT_MODBUS_ERROR);
+    }
+    if (sys_isSw2On() && errDetected) {
+        memset((void *)&modbus_rtu.err, 0, sizeof(modbus_rtu.err));
+    }
+    if (modbusRtu_txStream) {
+        modbusRtu_sendStream();
+        if (modbusRtu_txStream) {
+            return; // received frames wait for the end of the response
+        }
+    }
+    if (mr.length[mr.mainBuffer] > 0) {
+        // echo (frame size without CRC) and largest response
+        uint8_t txSize = MODBUS_RTU_FRAME_SIZE(GLOBAL_MODBUS_RTU_BUFSIZE - 2);
+        #if GLOBAL_MODBUS_ECHOREQUEST != 0
+            txSize += mr.length[mr.mainBuffer];
+        #endif
+        if (sys_getUart1TxFree() < txSize) {
+            sys_waitUart1TxFree(txSize); // previous response still in transmit buffer
+            return;
+        }
+        modbusRtu_handleFrame(mr.buffer[mr.mainBuffer], mr.length[mr.mainBuffer]);
+        sys_updateTaskTime(SYS_TASKTIME_MODBUS_LATENCY, mr.rxTimer[mr.mainBuffer]);
+        mr.length[mr.mainBuffer] = 0; // release buffer for receiver
+        mr.mainBuffer ^= 1;
+        if (mr.length[mr.mainBuffer] > 0) {
+            sys_setEvent(GLOBAL_EVENT_MODBUS_RX); // second buffer filled meanwhile
+        }
+    }
+}
+
+// resets the frame in reception, frames waiting for modbusRtu_main() are kept
+void modbusRtu_reset () {
+    mr.bIndex = 0;
+    mr.rxStatus = 0;
+    mr.crc = 0xffff;
+}
+
+void modbusRtu_setBitrate (uint32_t bitrate) {
+    uint16_t ticks = bitrate > MODBUS_RTU_T35_FIXED_BITRATE ? MODBUS_RTU_T35_FIXED_TICKS : MODBUS_RTU_T35_TICKS(bitrate);
+    uint8_t sreg = sys_enterCritical();
+    mr.t35Ticks = ticks;
+    sys_leaveCritical(sreg);
+}
+
+static uint16_t modbusRtu_txCrc;
+
+static void modbusRtu_sendByte (uint8_t b) {
+    modbusRtu_txCrc = _crc16_update(modbusRtu_txCrc, b);
+    fputc(b, sys.fOutModbus);
+}
+
+static void modbusRtu_sendCrc (void) {
+    uint16_t crc = modbusRtu_txCrc;
+    fputc(crc & 0xff, sys.fOutModbus);
+    fputc(crc >> 8, sys.fOutModbus);
+}
+
+// sends the values of a large read response as far as they fit into the transmit buffer,
+// continued by modbusRtu_main() on GLOBAL_EVENT_UART1_TX before the buffer runs empty
+// (half of the buffer is left, 7ms at 115200, 0.5ms at 1.5M)
+static void modbusRtu_sendStream (void) {
+    modbusRtu_txStream = !modbus_streamResponse(modbusRtu_sendByte, MODBUS_RTU_STREAM_SIZE);
+    if (!modbusRtu_txStream) {
+        modbusRtu_sendCrc();
+    }
+}
+
+// stream: values of a large read response follow the bytes of buffer (modbus_streamResponse())
+static void modbusRtu_send (uint8_t buffer[], uint8_t length, uint8_t stream) {
+    modbusRtu_txCrc = 0xffff;
+    for (uint8_t i = 0; i < length; i++) {
+        modbusRtu_sendByte(buffer[i]);
+    }
+    if (stream) {
+        modbusRtu_sendStream();
+    } else {
+        modbusRtu_sendCrc();
+    }
+}
+
+void modbusRtu_sendFrame (uint8_t buffer[], uint8_t length) {
+    modbusRtu_send(buffer, length, 0);
+}
+
+void modbusRtu_sendResponse (uint8_t buffer[], uint8_t length) {
+    modbusRtu_send(buffer, length, 1);
+    if (mr.debugLevel >= GLOBAL_DEBUG_LEVEL_FINE) {
+        sys_log(LOG_MODBUS_RTU_RESPONSE, buffer, length);
+    }
+}
+
+// length: frame size including CRC (already verified)
+void modbusRtu_handleFrame (uint8_t buffer[], uint8_t length) {
+    sys_setEvent(GLOBAL_EVENT_MODBUS_FRAME);
+    mr.frameCnt++;
+    if (mr.debugLevel >= GLOBAL_DEBUG_LEVEL_FINE) {
+        sys_log(LOG_MODBUS_RTU_REQUEST, buffer, length);
+    }
+    #if GLOBAL_MODBUS_ECHOREQUEST != 0
+        modbusRtu_sendFrame(buffer, length - 2);
+    #endif
+    // buffer must keep space for CRC of response
+    uint8_t size = modbus_handleRequest(buffer, length - 2, GLOBAL_MODBUS_RTU_BUFSIZE - 2);
+    if (size > 0) {
+        modbusRtu_sendResponse(buffer, size);
+    }
+}
+
+// called from USART1_RX_vect
+// CRC is updated with every byte, a valid frame (including CRC) ends with crc == 0
+void modbusRtu_handleByte (uint8_t b) {
+    sys_startUart1Timeout(mr.t35Ticks);
+
+    if (mr.length[mr.rxBuffer] > 0) {
+        if (modbus.rxMode == MODBUS_MODE_RTU) {
+            sys_inc8BitCnt(&mr.err.byteWhileBusy);
+        }
+        mr.rxStatus |= MODBUS_RTU_RXSTATUS_DROPPED;
+        return;
+    }
+    if (mr.rxStatus & MODBUS_RTU_RXSTATUS_DROPPED) {
+        return; // rest of a frame which is already incomplete
+    }
+    if (mr.bIndex >= GLOBAL_MODBUS_RTU_BUFSIZE) {
+        mr.rxStatus |= MODBUS_RTU_RXSTATUS_OVERFLOW;
+        return;
+    }
+    mr.buffer[mr.rxBuffer][mr.bIndex++] = b;
+    mr.crc = _crc16_update(mr.crc, b);
+}
+
+// called from TIMER1_COMPA_vect, 3.5 character times (1750us above 19200 bit/s) after last received byte
+void modbusRtu_handleFrameGap () {
+    if (mr.bIndex == 0 && mr.rxStatus == 0) {
+        return;
+    }
+    // on auto detection errors are not counted (could be a Modbus ASCII frame)
+    uint8_t isRtu = modbus.rxMode == MODBUS_MODE_RTU;
+    if (mr.rxStatus & MODBUS_RTU_RXSTATUS_DROPPED) {
+        // already counted as byteWhileBusy
+    } else if (mr.rxStatus & MODBUS_RTU_RXSTATUS_OVERFLOW) {
+        if (isRtu) {
+            sys_inc8BitCnt(&mr.err.frameOverflow);
+        }
+    } else if (mr.bIndex < 4) {
+        if (isRtu) {
+            sys_inc8BitCnt(&mr.err.invalidFrame);
+        }
+    } else if (mr.crc != 0) {
+        if (isRtu) {
+            sys_inc8BitCnt(&mr.err.crcError);
+        }
+    } else {
+        modbus.rxMode = MODBUS_MODE_RTU;
+        mr.length[mr.rxBuffer] = mr.bIndex;
+        mr.rxTimer[mr.rxBuffer] = sys_getTaskTimer();
+        mr.rxBuffer ^= 1;
+        sys_setEvent(GLOBAL_EVENT_MODBUS_RX);
+    }
+    modbusRtu_reset();
+}
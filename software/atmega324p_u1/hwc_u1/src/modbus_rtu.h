@@ -0,0 +1,58 @@
+#ifndef MODBUS_RTU_H_
+#define MODBUS_RTU_H_
+
+#include <stdint.h>
+#include "global.h"
+
+// timer 1 runs with F_CPU/8, one character = 11 bit (start, 8 data, parity/stop, stop)
+// above 19200 bit/s the gap is fixed to 1750us (Modbus serial line spec), gaps of the master
+// between two bytes (Linux, USB serial adapter) must not end the frame
+#define MODBUS_RTU_T35_TICKS(bitrate)   ((uint16_t)((F_CPU / 8) * 35 / 10 * 11 / (bitrate)))
+#define MODBUS_RTU_T35_FIXED_BITRATE    19200
+#define MODBUS_RTU_T35_FIXED_TICKS      ((uint16_t)(F_CPU / 8 / 1000 * 1750 / 1000))
+
+#define MODBUS_RTU_RXSTATUS_OVERFLOW 0x01
+#define MODBUS_RTU_RXSTATUS_DROPPED  0x02  // bytes dropped, both buffers in use
+
+#define MODBUS_RTU_STREAM_SIZE       4     // one streamed register value and CRC
+#define MODBUS_RTU_FRAME_SIZE(length) ((length) + 2)  // frame and CRC
+
+// echo of the largest request and the largest response must fit
+#if 2 * GLOBAL_MODBUS_RTU_BUFSIZE > GLOBAL_UART1_TXBUFSIZE - 1  // ring buffer keeps one byte free
+#error "UART1 transmit buffer too small for Modbus RTU"
+#endif
+
+struct ModbusRtuErrorCnt { // size word aligned !
+    uint8_t crcError;
+    uint8_t invalidFrame;
+    uint8_t frameOverflow;
+    uint8_t byteWhileBusy;
+};
+
+struct ModbusRtu {
+    uint8_t version;
+    uint8_t debugLevel;
+    struct ModbusRtuErrorCnt err;
+    uint8_t buffer[2][GLOBAL_MODBUS_RTU_BUFSIZE];  // ping-pong, receiver uses one while other is handled
+    uint8_t length[2];   // > 0 -> frame (with CRC) waiting for modbusRtu_main()
+    uint16_t rxTimer[2]; // sys_getTaskTimer() at end of frame (after frame gap)
+    uint8_t rxBuffer;    // buffer used by receiver
+    uint8_t mainBuffer;  // next buffer handled by modbusRtu_main()
+    uint8_t bIndex;
+    uint8_t rxStatus;
+    uint16_t crc;
+    uint16_t frameCnt;
+    uint16_t t35Ticks;  // frame gap for current UART1 bit rate
+};
+
+extern struct ModbusRtu modbus_rtu;
+
+void modbusRtu_init ();
+void modbusRtu_main ();
+void modbusRtu_reset ();
+void modbusRtu_setBitrate (uint32_t bitrate);
+void modbusRtu_handleByte (uint8_t b);
+void modbusRtu_handleFrameGap ();
+void modbusRtu_sendFrame (uint8_t buffer[], uint8_t length);
+
+#endif // MODBUS_RTU_H_
@@ -0,0 +1,55 @@
+#include <stdint.h>
+#include <avr/pgmspace.h>
+
+#include "global.h"
+#include "sys.h"
+#include "pt1000.h"
+
+// PT1000 linearisation
+// The front end (bridge and LM358, see kicad/io.sch) is modelled linear:
+//   U = GLOBAL_PT1000_MV_AT_1200R + (R - 1200 Ohm) * GLOBAL_PT1000_UV_PER_OHM
+// The table holds the temperature for equidistant ADC values, so the index is
+// adc >> PT1000_TABLE_SHIFT and the interpolation needs no division.
+// All entries are constant expressions evaluated by the compiler (no float code
+// in the firmware), the inverse of Callendar-Van Dusen (IEC 60751) for t >= 0:
+//   R(t) = R0 * (1 + A*t + B*t^2)  ->  t = (-A + sqrt(A^2 - 4*B*(1 - R/R0))) / (2*B)
+// The C term for t < 0 changes the result less than 0.01 degree above -30 degree.
+
+#define PT1000_R0           1000.0
+#define PT1000_A            3.9083E-3
+#define PT1000_B            -5.775E-7
+
+#define PT1000_TABLE_BITS   5
+#define PT1000_TABLE_SHIFT  (SYS_ADC_BITS - PT1000_TABLE_BITS)
+#define PT1000_TABLE_SIZE   ((1 << PT1000_TABLE_BITS) + 1)
+#define PT1000_ADC_MIN      (1 << (SYS_ADC_BITS - 6))
+#define PT1000_ADC_MAX      ((1 << SYS_ADC_BITS) - PT1000_ADC_MIN)
+
+#define PT1000_MV(adc)      ((double)(adc) * GLOBAL_ADC_VREF_MV / (1L << SYS_ADC_BITS))
+#define PT1000_R(adc)       (1200.0 + (PT1000_MV(adc) - GLOBAL_PT1000_MV_AT_1200R) * 1000.0 / GLOBAL_PT1000_UV_PER_OHM)
+#define PT1000_T(r)         ((-PT1000_A + __builtin_sqrt(PT1000_A * PT1000_A - 4 * PT1000_B * (1 - (r) / PT1000_R0))) / (2 * PT1000_B))
+#define PT1000_T100(adc)    (PT1000_T(PT1000_R(adc)) * 100)
+#define PT1000_ENTRY(i)     (int16_t)(PT1000_T100((uint32_t)(i) << PT1000_TABLE_SHIFT) + (PT1000_T100((uint32_t)(i) << PT1000_TABLE_SHIFT) < 0 ? -0.5 : 0.5))
+#define PT1000_ENTRIES_4(i) PT1000_ENTRY(i), PT1000_ENTRY(i + 1), PT1000_ENTRY(i + 2), PT1000_ENTRY(i + 3)
+
+#if PT1000_TABLE_SHIFT < 1
+  #error "Error: PT1000_TABLE_SHIFT too small"
+#endif
+
+// temperature [1/100 degree] for adc = index << PT1000_TABLE_SHIFT
+static const int16_t pt1000_table[PT1000_TABLE_SIZE] PROGMEM = {
+    PT1000_ENTRIES_4(0),  PT1000_ENTRIES_4(4),  PT1000_ENTRIES_4(8),  PT1000_ENTRIES_4(12),
+    PT1000_ENTRIES_4(16), PT1000_ENTRIES_4(20), PT1000_ENTRIES_4(24), PT1000_ENTRIES_4(28),
+    PT1000_ENTRY(32)
+};
+
+int16_t pt1000_toTemperature (uint16_t adc) {
+    if (adc < PT1000_ADC_MIN || adc > PT1000_ADC_MAX) {
+        return PT1000_INVALID;
+    }
+    uint8_t i = adc >> PT1000_TABLE_SHIFT;
+    int16_t t0 = pgm_read_word(&pt1000_table[i]);
+    int16_t t1 = pgm_read_word(&pt1000_table[i + 1]);
+    uint16_t frac = adc & ((1 << PT1000_TABLE_SHIFT) - 1);
+    return t0 + (int16_t)(((int32_t)(t1 - t0) * frac) >> PT1000_TABLE_SHIFT);
+}
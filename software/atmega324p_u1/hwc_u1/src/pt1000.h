@@ -0,0 +1,11 @@
+#ifndef PT1000_H_
+#define PT1000_H_
+
+#include <stdint.h>
+
+#define PT1000_INVALID  ((int16_t)0x8000)  // sensor open or shorted, ADC out of range
+
+// ADC value (SYS_ADC_BITS) to temperature in 1/100 degree Celsius
+int16_t pt1000_toTemperature (uint16_t adc);
+
+#endif // PT1000_H_
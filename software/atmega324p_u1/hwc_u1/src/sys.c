@@ -6,15 +6,23 @@
 #include <avr/io.h>
 #include <avr/interrupt.h>
 #include <avr/wdt.h>
+#include <avr/sleep.h>
 #include "./global.h"
 #include <util/delay.h>
 
 #include "./sys.h"
-#include "./modbus_ascii.h"
+#include "./modbus.h"
+#include "./modbus_rtu.h"
 #include "./app.h"
+#include "./log.h"
 
 // defines
 
+#if (GLOBAL_LOG_BUFSIZE & (GLOBAL_LOG_BUFSIZE - 1)) != 0 || GLOBAL_LOG_BUFSIZE > 128
+  #error "Error: GLOBAL_LOG_BUFSIZE must be a power of 2 (max. 128)"
+#endif
+#define SYS_LOG_MASK (GLOBAL_LOG_BUFSIZE - 1)
+
 
 #define SYS_UART0_BYTE_RECEIVED (UCSR0A & (1 << RXC0))
 #define SYS_UART0_UDR_IS_EMPTY (UCSR0A & (1 << UDRE0))
@@ -29,6 +37,26 @@
 // declarations and definations
 
 struct Sys sys;
+struct Sys_TaskTimes sys_taskTimes;
+
+struct Sys_TaskTimeSum {
+    uint32_t sum;
+    uint16_t cnt;
+};
+
+static struct Sys_TaskTimeSum sys_taskTimeSum[SYS_TASKTIME_SLOTS];
+static uint16_t sys_taskTimeBudget[SYS_TASKTIME_SLOTS];  // TCNT1 ticks, more is counted as overrun
+
+// periodic task, called by TIMER0_COMPA_vect (interrupts enabled) if (tick & mask) == phase
+struct Sys_Task {
+    void (*run)(void);
+    uint8_t  mask;    // period - 1
+    uint8_t  phase;
+    uint16_t budget;  // worst case execution time in TCNT1 ticks
+};
+
+static struct Sys_Task sys_task[SYS_TASKS];
+static uint8_t sys_taskCnt = 0;
 
 // functions
 
@@ -44,6 +72,13 @@ static FILE sys_fOutModbus = FDEV_SETUP_STREAM(sys_uart1_putch, NULL, _FDEV_SETU
 void sys_init () {
     memset((void *)&sys, 0, sizeof(sys));
     sys.version = 1;
+    sys.overcurrent.level = SYS_OVERCURRENT_OFF;
+    GPIOR0 = 0; // events
+    for (uint8_t i = 0; i < SYS_TASKTIME_SLOTS; i++) {
+        sys_taskTimeBudget[i] = SYS_TASKTIME_BUDGET;
+    }
+    set_sleep_mode(SLEEP_MODE_IDLE); // timers, UARTs and ADC keep running
+    sys_clearTaskTimes();
     _delay_ms(1);
 
     // DDRA |= 0x07;  // Debug
@@ -75,15 +110,30 @@ void sys_init () {
     TIMSK0 = (1 << OCIE0A);
     TIFR0  = (1 << OCF0A);
 
-    // Timer 1 for Modbus-RTU timing measurments
-    // TCCR1A = 0;
-    // TCCR1B = (1 << CS11);  // f=12MHz
-    // OCR1A  = 0xffff;
-    // TIMSK1 = (1 << OCIE1A);
-
-    // ADC
-    ADMUX = (1 << REFS1) | (0 << REFS0) | (1 << ADLAR) | 0;
-    ADCSRA = (1 << ADEN) | 0x07;
+    // Timer 1 free running (f=1.5MHz) for Modbus-RTU timing measurments
+    // OCR1A is used for frame gap detection (see sys_startUart1Timeout)
+    // overflow extends TCNT1 to 32 bit timestamps (see sys_getTimestamp)
+    TCCR1A = 0;
+    TCCR1B = (1 << CS11);
+    TIMSK1 = (1 << TOIE1);
+
+    // Sensor 1 / S0 Energymeter: pin change interrupt PCINT9 (PB1)
+    // (ICP1 is PD6, used for LED PT1000-1-g)
+    sys.sensor1 = sys_isSensor1On();
+    PCMSK1 = (1 << PCINT9);
+    PCIFR = (1 << PCIF1);
+    PCICR |= (1 << PCIE1);
+
+    // ADC, 10 bit right adjusted, auto trigger by timer 0 compare match (10kHz)
+    // f_ADC = 12MHz / 64 = 187.5kHz -> 72us per conversion
+    sys.adc.filterShift = GLOBAL_ADC_FILTER_SHIFT;
+    sys.adc.channel = SYS_ADC_CH_4TO20MA;
+    sys.adc.slot = SYS_ADC_SLOT_4TO20MA;
+    sys.adc.pt1000 = SYS_ADC_CH_PT1000_1;
+    ADMUX = (1 << REFS1) | (0 << REFS0) | SYS_ADC_CH_4TO20MA;
+    DIDR0 = (1 << ADC2D) | (1 << ADC1D) | (1 << ADC0D);
+    ADCSRB = (1 << ADTS1) | (1 << ADTS0);
+    ADCSRA = (1 << ADEN) | (1 << ADATE) | (1 << ADIE) | (1 << ADPS2) | (1 << ADPS1);
 
     // UART0 (Mini USB)
     UBRR0L = (F_CPU/GLOBAL_UART0_BITRATE + 4)/8 - 1;
@@ -127,23 +177,6 @@ void sys_inc16BitCnt (uint16_t *count) {
 }
 
 
-void sys_sei (void) {
-    if (sys.flags & SYS_FLAG_SREG_I) {
-        sei();
-    }
-}
-
-
-void sys_cli (void) {
-    if (SREG & 0x80) {
-        sys.flags |= SYS_FLAG_SREG_I;
-    } else {
-        sys.flags &= ~SYS_FLAG_SREG_I;
-    }
-    cli();
-}
-
-
 void sys_newline (void) {
     printf("\n");
 }
@@ -165,27 +198,308 @@ int sys_uart0_getch (FILE *f) {
 }
 
 
+// text is queued in the log ring buffer between the binary records, waits only if buffer is full
+// with disabled interrupts (before sei(), printf must not be used in ISRs) the byte is sent directly
 int sys_uart0_putch (char c, FILE *f) {
     if (f != stdout) {
         return EOF;
     }
-    while (!SYS_UART0_UDR_IS_EMPTY) {
+    if (!(SREG & (1 << SREG_I))) {
+        while (!SYS_UART0_UDR_IS_EMPTY) {
+        }
+        SYS_UDR0 = (uint8_t)c;
+        return (int)c;
     }
-    SYS_UDR0 = (uint8_t)c;
+    uint8_t done;
+    do {
+        uint8_t sreg = sys_enterCritical();
+        done = ((sys.log.rpos - sys.log.wpos - 1) & SYS_LOG_MASK) > 0;
+        if (done) {
+            sys.log.buffer[sys.log.wpos] = (uint8_t)c;
+            sys.log.wpos = (sys.log.wpos + 1) & SYS_LOG_MASK;
+            UCSR0B |= (1 << UDRIE0);
+        }
+        sys_leaveCritical(sreg);
+    } while (!done);
     return (int)c;
 }
 
+// binary log record (see log.h), never waits, the record is dropped if buffer is full
+// callable from main loop and ISR
+void sys_log (uint8_t id, const uint8_t *data, uint8_t length) {
+    uint8_t sreg = sys_enterCritical();
+    uint8_t space = (sys.log.rpos - sys.log.wpos - 1) & SYS_LOG_MASK;
+    if ((uint16_t)length + LOG_HEADER_SIZE > space) {
+        sys_inc16BitCnt(&sys.err.logDropped_u16);
+        sys_leaveCritical(sreg);
+        return;
+    }
+    uint8_t *b = sys.log.buffer;
+    uint8_t w = sys.log.wpos;
+    uint16_t t = sys.uptimeMs;
+    b[w] = LOG_SYNC;  w = (w + 1) & SYS_LOG_MASK;
+    b[w] = id;        w = (w + 1) & SYS_LOG_MASK;
+    b[w] = length;    w = (w + 1) & SYS_LOG_MASK;
+    b[w] = t & 0xff;  w = (w + 1) & SYS_LOG_MASK;
+    b[w] = t >> 8;    w = (w + 1) & SYS_LOG_MASK;
+    while (length-- > 0) {
+        b[w] = *data++;
+        w = (w + 1) & SYS_LOG_MASK;
+    }
+    sys.log.wpos = w;
+    UCSR0B |= (1 << UDRIE0);
+    sys_leaveCritical(sreg);
+}
+
+// must be called with disabled interrupts, returns 0 if buffer is full
+uint8_t sys_uart1_enqueue (uint8_t b) {
+    uint8_t wpos = sys.uart1.txbuf.wpos_u8 + 1;
+    if (wpos >= GLOBAL_UART1_TXBUFSIZE) {
+        wpos = 0;
+    }
+    if (wpos == sys.uart1.txbuf.rpos_u8) {
+        return 0;
+    }
+    sys.uart1.txbuf.buffer_u8[sys.uart1.txbuf.wpos_u8] = b;
+    sys.uart1.txbuf.wpos_u8 = wpos;
+    UCSR1A = (1 << U2X1) | (1 << TXC1); // clear TXC1, set again after last byte (sys_isUart1TxComplete)
+    UCSR1B |= (1 << UDRIE1);
+    return 1;
+}
+
+// bytes are sent by USART1_UDRE_vect, waits only if transmit buffer is full
 int sys_uart1_putch (char c, FILE *f) {
     if (f != &sys_fOutModbus) {
         return EOF;
     }
-    while (!SYS_UART1_UDR_IS_EMPTY) {
-    }
-    SYS_UDR1 = (uint8_t)c;
+    uint8_t done;
+    do {
+        uint8_t sreg = sys_enterCritical();
+        done = sys_uart1_enqueue((uint8_t)c);
+        sys_leaveCritical(sreg);
+    } while (!done);
     return (int)c;
 }
 
 
+// must be called with disabled interrupts
+static inline uint8_t sys_uart1_free (void) {
+    int16_t used = sys.uart1.txbuf.wpos_u8 - sys.uart1.txbuf.rpos_u8;
+    if (used < 0) {
+        used += GLOBAL_UART1_TXBUFSIZE;
+    }
+    return GLOBAL_UART1_TXBUFSIZE - 1 - used;
+}
+
+// bytes which can be written without waiting
+uint8_t sys_getUart1TxFree () {
+    uint8_t sreg = sys_enterCritical();
+    uint8_t rv = sys_uart1_free();
+    sys_leaveCritical(sreg);
+    return rv;
+}
+
+// GLOBAL_EVENT_UART1_TX is posted as soon as free bytes are available in the transmit buffer
+void sys_waitUart1TxFree (uint8_t free) {
+    uint8_t sreg = sys_enterCritical();
+    if (sys_uart1_free() >= free) {
+        sys.uart1.txWait = 0;
+        sys_setEvent(GLOBAL_EVENT_UART1_TX);
+    } else {
+        sys.uart1.txWait = free;
+    }
+    sys_leaveCritical(sreg);
+}
+
+// 1 if transmit buffer is empty and the last byte has left the shift register
+uint8_t sys_isUart1TxComplete () {
+    uint8_t sreg = sys_enterCritical();
+    uint8_t rv = sys.uart1.txbuf.rpos_u8 == sys.uart1.txbuf.wpos_u8 && (UCSR1A & (1 << TXC1));
+    sys_leaveCritical(sreg);
+    return rv;
+}
+
+// U2X mode: bitrate = F_CPU / 8 / (UBRR + 1), exact for 1.5M, 750k and 500k (115200 +0.16%)
+// bytes in reception or transmission are corrupted
+void sys_setUart1Bitrate (uint32_t bitrate) {
+    uint8_t sreg = sys_enterCritical();
+    UBRR1L = (F_CPU/bitrate + 4)/8 - 1;
+    UBRR1H = 0x00;
+    sys_leaveCritical(sreg);
+}
+
+
+// restart UART1 timeout, TIMER1_COMPA_vect is called after ticks * 0.667us
+// must be called with disabled interrupts (from ISR)
+void sys_startUart1Timeout (uint16_t ticks) {
+    OCR1A = TCNT1 + ticks;
+    TIFR1 = (1 << OCF1A);
+    TIMSK1 |= (1 << OCIE1A);
+}
+
+
+//----------------------------------------------------------------------------
+
+uint16_t sys_getAdcRaw (void) {
+    uint8_t sreg = sys_enterCritical();
+    uint16_t rv = sys.adc.ch[SYS_ADC_CH_4TO20MA].raw;
+    sys_leaveCritical(sreg);
+    return rv;
+}
+
+uint16_t sys_getAdcValue (void) {
+    uint8_t sreg = sys_enterCritical();
+    uint16_t rv = sys.adc.ch[SYS_ADC_CH_4TO20MA].value;
+    sys_leaveCritical(sreg);
+    return rv;
+}
+
+// filtered value of channel (SYS_ADC_BITS)
+uint16_t sys_getAdcChannel (uint8_t channel) {
+    if (channel >= SYS_ADC_CHANNELS) {
+        return 0;
+    }
+    uint8_t sreg = sys_enterCritical();
+    uint16_t rv = sys.adc.ch[channel].filtered;
+    sys_leaveCritical(sreg);
+    return rv;
+}
+
+uint16_t sys_getAdcFiltered (void) {
+    return sys_getAdcChannel(SYS_ADC_CH_4TO20MA);
+}
+
+// uptime [ms] (low word) of the last value of the 4-20mA input
+uint16_t sys_getAdcAt (void) {
+    return sys_getAdcChannelAt(SYS_ADC_CH_4TO20MA);
+}
+
+uint16_t sys_getAdcChannelAt (uint8_t channel) {
+    if (channel >= SYS_ADC_CHANNELS) {
+        return 0;
+    }
+    uint8_t sreg = sys_enterCritical();
+    uint16_t rv = sys.adc.ch[channel].at;
+    sys_leaveCritical(sreg);
+    return rv;
+}
+
+uint16_t sys_getAdcFilterShift (void) {
+    return sys.adc.filterShift;
+}
+
+uint8_t sys_setAdcFilterShift (uint16_t shift) {
+    if (shift > 8) {
+        return 1;
+    }
+    sys.adc.filterShift = shift;
+    return 0;
+}
+
+//----------------------------------------------------------------------------
+
+// interrupts must be disabled, a pending overflow is not handled yet
+static uint32_t sys_readTimestamp (void) {
+    uint16_t low = TCNT1;
+    uint16_t high = sys.timer1High;
+    if ((TIFR1 & (1 << TOV1)) && low < 0x8000) {
+        high++;
+    }
+    return ((uint32_t)high << 16) | low;
+}
+
+// TCNT1 extended to 32 bit (SYS_TIMESTAMP_FREQ), readable from main loop and ISR
+uint32_t sys_getTimestamp (void) {
+    uint8_t sreg = sys_enterCritical();
+    uint32_t t = sys_readTimestamp();
+    sys_leaveCritical(sreg);
+    return t;
+}
+
+// milliseconds since reset, readable from main loop and ISR
+uint32_t sys_getUptimeMs (void) {
+    uint8_t sreg = sys_enterCritical();
+    uint32_t rv = sys.uptimeMs;
+    sys_leaveCritical(sreg);
+    return rv;
+}
+
+// TCNT1 (F_CPU/8), readable from main loop and ISR (16 bit access uses the shared TEMP register)
+uint16_t sys_getTaskTimer (void) {
+    uint8_t sreg = sys_enterCritical();
+    uint16_t t = TCNT1;
+    sys_leaveCritical(sreg);
+    return t;
+}
+
+// start: sys_getTaskTimer() before execution
+void sys_updateTaskTime (uint8_t slot, uint16_t start) {
+    uint16_t t = sys_getTaskTimer() - start;
+    struct Sys_TaskTime *tt = &sys_taskTimes.slot[slot];
+    struct Sys_TaskTimeSum *ts = &sys_taskTimeSum[slot];
+    if (t < tt->min) {
+        tt->min = t;
+    }
+    if (t > tt->max) {
+        tt->max = t;
+    }
+    if (t > sys_taskTimeBudget[slot]) {
+        sys_inc16BitCnt(&tt->overrun);
+    }
+    ts->sum += t;
+    if (++ts->cnt >= (1 << SYS_TASKTIME_AVG_SHIFT)) {
+        tt->avg = ts->sum >> SYS_TASKTIME_AVG_SHIFT;
+        ts->sum = 0;
+        ts->cnt = 0;
+    }
+}
+
+// registers a periodic task, called every period ticks (500us, power of 2, max. 256) in tick phase (0..period-1)
+// budgetUs: worst case execution time, the budgets of all tasks due in the same tick must fit into one tick,
+// so a new task cannot delay the existing ones into the next tick (jitter)
+// returns the task index (task time slot) or -1 if the table is full or the task does not fit
+int8_t sys_addTask (void (*run)(void), uint16_t period, uint8_t phase, uint16_t budgetUs) {
+    if (sys_taskCnt >= SYS_TASKS || period == 0 || period > SYS_TASK_MAX_PERIOD || (period & (period - 1)) != 0 ||
+        phase >= period || budgetUs == 0 || budgetUs > SYS_TASK_TICK_US) {
+        return -1;
+    }
+    uint16_t budget = (uint32_t)budgetUs * (F_CPU / 8 / 1000) / 1000;
+    for (uint16_t tick = phase; tick < SYS_TASK_MAX_PERIOD; tick += period) {
+        uint16_t sum = budget;
+        for (uint8_t i = 0; i < sys_taskCnt; i++) {
+            if ((tick & sys_task[i].mask) == sys_task[i].phase) {
+                sum += sys_task[i].budget;
+            }
+        }
+        if (sum > SYS_TASKTIME_BUDGET) {
+            return -1;
+        }
+    }
+    uint8_t sreg = sys_enterCritical();
+    uint8_t index = sys_taskCnt;
+    sys_task[index].run = run;
+    sys_task[index].mask = period - 1;
+    sys_task[index].phase = phase;
+    sys_task[index].budget = budget;
+    sys_taskTimeBudget[SYS_TASKTIME_TASK + index] = budget;
+    sys_taskCnt++;
+    sys_leaveCritical(sreg);
+    return index;
+}
+
+void sys_clearTaskTimes (void) {
+    uint8_t sreg = sys_enterCritical();
+    memset((void *)&sys_taskTimes, 0, sizeof(sys_taskTimes));
+    memset((void *)&sys_taskTimeSum, 0, sizeof(sys_taskTimeSum));
+    sys_taskTimes.version = 1;
+    sys_taskTimes.slots = SYS_TASKTIME_SLOTS;
+    for (uint8_t i = 0; i < SYS_TASKTIME_SLOTS; i++) {
+        sys_taskTimes.slot[i].min = 0xffff;
+    }
+    sys_leaveCritical(sreg);
+}
+
+
 uint8_t sys_uart0_available (void) {
     return sys.uart0.txbuf.wpos_u8 >= sys.uart0.txbuf.rpos_u8
              ? sys.uart0.txbuf.wpos_u8 - sys.uart0.txbuf.rpos_u8
@@ -197,7 +511,7 @@ uint8_t sys_uart0_available (void) {
 
 int16_t sys_uart0_getBufferByte (uint8_t pos) {
     int16_t value;
-    sys_cli();
+    uint8_t sreg = sys_enterCritical();
 
     if (pos >= sys_uart0_available()) {
         value = -1;
@@ -208,20 +522,20 @@ int16_t sys_uart0_getBufferByte (uint8_t pos) {
         value = sys.uart0.txbuf.buffer_u8[bufpos];
     }
 
-    sys_sei();
+    sys_leaveCritical(sreg);
     return value;
 }
 
 
 void sys_uart0_flush (void) {
-    sys_cli();
+    uint8_t sreg = sys_enterCritical();
     while (SYS_UART0_BYTE_RECEIVED)
         sys.uart0.txbuf.buffer_u8[0] = SYS_UDR0;
 
     sys.uart0.txbuf.rpos_u8 = 0;
     sys.uart0.txbuf.wpos_u8 = 0;
     sys.uart0.errcnt_u8 = 0;
-    sys_sei();
+    sys_leaveCritical(sreg);
 }
 
 
@@ -229,40 +543,45 @@ void sys_uart0_flush (void) {
 // Event Handling
 //****************************************************************************
 
-Sys_Event sys_setEvent (Sys_Event event) {
-    sys_cli();
-    uint8_t eventIsPending = ((sys.eventFlag & event) != 0);
-    sys.eventFlag |= event;
-    sys_sei();
-    return eventIsPending;
-}
+// see sys_setEvent(), sys_clearEvent() and sys_isEventPending() in sys.h
 
-
-Sys_Event sys_clearEvent (Sys_Event event) {
-    sys_cli();
-    uint8_t eventIsPending = ((sys.eventFlag & event) != 0);
-    sys.eventFlag &= ~event;
-    sys_sei();
-    return eventIsPending;
+// main loop: sleeps (idle mode) until one of the events in mask is pending,
+// returns the pending events of mask and clears them
+Sys_Event sys_waitForEvents (Sys_Event mask) {
+    cli();
+    while ((GPIOR0 & mask) == 0) {
+        sleep_enable();
+        sei(); // instruction after sei() is executed before a pending interrupt, no wakeup is lost
+        sleep_cpu();
+        sleep_disable();
+        cli();
+    }
+    Sys_Event events = GPIOR0 & mask;
+    GPIOR0 &= ~events;
+    sei();
+    return events;
 }
 
 
-Sys_Event sys_isEventPending (Sys_Event event) {
-    return (sys.eventFlag & event) != 0;
-}
-
 //****************************************************************************
 // SSR Handling
 //****************************************************************************
 
+#define SYS_SSR_MASK ((1 << PC2) | (1 << PC3) | (1 << PC4) | (1 << PC5))
+
+// SSRs stay off while an over-current fault is latched
 void sys_setSSR (uint8_t index, uint8_t on) {
     if (on) {
-        switch (index) {
-            case 0: PORTC |= (1 << PC2); return;
-            case 1: PORTC |= (1 << PC3); return;
-            case 2: PORTC |= (1 << PC4); return;
-            case 3: PORTC |= (1 << PC5); return;
+        uint8_t sreg = sys_enterCritical(); // no trip between check and switching on
+        if (!sys.overcurrent.fault) {
+            switch (index) {
+                case 0: PORTC |= (1 << PC2); break;
+                case 1: PORTC |= (1 << PC3); break;
+                case 2: PORTC |= (1 << PC4); break;
+                case 3: PORTC |= (1 << PC5); break;
+            }
         }
+        sys_leaveCritical(sreg);
     } else {
         switch (index) {
             case 0: PORTC &= ~(1 << PC2); return;
@@ -310,8 +629,63 @@ uint8_t sys_isSensor2On () {
 // 4 to 20mA handling
 //****************************************************************************
 
+// the output stays off while an over-current fault is latched
 void sys_setPwm4To20mA (uint8_t value) {
-    OCR2A = 0xff - value;
+    uint8_t sreg = sys_enterCritical(); // no trip between check and OCR2A write
+    OCR2A = sys.overcurrent.fault ? 0xff : 0xff - value;
+    sys_leaveCritical(sreg);
+}
+
+//****************************************************************************
+// Over-current trip of 4-20mA output
+//****************************************************************************
+
+uint16_t sys_getOvercurrentLevel () {
+    uint8_t sreg = sys_enterCritical();
+    uint16_t rv = sys.overcurrent.level;
+    sys_leaveCritical(sreg);
+    return rv;
+}
+
+// level: raw ADC value (10 bit), SYS_OVERCURRENT_OFF disables the trip
+void sys_setOvercurrentLevel (uint16_t level) {
+    uint8_t sreg = sys_enterCritical();
+    sys.overcurrent.level = level;
+    sys.overcurrent.cnt = 0;
+    sys_leaveCritical(sreg);
+}
+
+uint8_t sys_isOvercurrentFault () {
+    return sys.overcurrent.fault;
+}
+
+// outputs are not restored, the next sys_setPwm4To20mA() / sys_setSSR() switches them on again
+void sys_clearOvercurrentFault () {
+    uint8_t sreg = sys_enterCritical();
+    sys.overcurrent.fault = 0;
+    sys.overcurrent.cnt = 0;
+    sys_leaveCritical(sreg);
+}
+
+// called from ADC_vect for every conversion of SYS_ADC_CH_4TO20MA (not decimated, at most 300us apart)
+// GLOBAL_OVERCURRENT_SAMPLES consecutive conversions >= level trip, a single spike does not
+static inline void sys_checkOvercurrent (uint16_t sample) {
+    struct Sys_Overcurrent *oc = &sys.overcurrent;
+    if (sample < oc->level) {
+        oc->cnt = 0;
+        return;
+    }
+    if (++oc->cnt < GLOBAL_OVERCURRENT_SAMPLES) {
+        return;
+    }
+    oc->cnt = 0;
+    OCR2A = 0xff;
+    PORTC &= ~SYS_SSR_MASK;
+    if (!oc->fault) {
+        oc->fault = 1;
+        oc->at = sys.uptimeMs;
+        sys_inc16BitCnt(&sys.err.overcurrent_u16);
+    }
 }
 
 //****************************************************************************
@@ -388,12 +762,14 @@ void sys_setLedPwmGreen (uint8_t on) {
 }
 
 
+// writing 1 to PINx toggles the pin in hardware (single sbi), PORTC ^= would be a read-modify-write
+// and could restore SSR bits cleared by the over-current trip in ADC_vect
 void sys_toggleLifeLed () {
-    PORTC ^= (1 << PC6);
+    PINC = (1 << PC6);
 }
 
 void sys_toggleLedPwmGreen () {
-    PORTD ^= (1 << PD4);
+    PIND = (1 << PD4);
 }
 
 
@@ -417,13 +793,34 @@ ISR (USART0_RX_vect) {
 
 ISR (USART1_RX_vect) {
     uint8_t b = UDR1;
-    #if GLOBAL_MODBUS_ECHOREQUEST != 0
-        UDR1 = b;
-    #endif
     #if GLOBAL_MODBUS_DEBUGLEVEL > 5
-        printf(" %02x", b);
+        sys_log(LOG_UART1_RX, &b, 1);
     #endif
-    modbusAscii_handleModbusAsciiByte((char)b);
+    modbus_handleUart1Byte(b);
+}
+
+ISR (USART0_UDRE_vect) {
+    if (sys.log.rpos == sys.log.wpos) {
+        UCSR0B &= ~(1 << UDRIE0);
+        return;
+    }
+    UDR0 = sys.log.buffer[sys.log.rpos];
+    sys.log.rpos = (sys.log.rpos + 1) & SYS_LOG_MASK;
+}
+
+ISR (USART1_UDRE_vect) {
+    if (sys.uart1.txbuf.rpos_u8 == sys.uart1.txbuf.wpos_u8) {
+        UCSR1B &= ~(1 << UDRIE1);
+        return;
+    }
+    UDR1 = sys.uart1.txbuf.buffer_u8[sys.uart1.txbuf.rpos_u8++];
+    if (sys.uart1.txbuf.rpos_u8 >= GLOBAL_UART1_TXBUFSIZE) {
+        sys.uart1.txbuf.rpos_u8 = 0;
+    }
+    if (sys.uart1.txWait != 0 && sys_uart1_free() >= sys.uart1.txWait) {
+        sys.uart1.txWait = 0;
+        sys_setEvent(GLOBAL_EVENT_UART1_TX);
+    }
 }
 
 // Timer 0 Output/Compare Interrupt
@@ -436,31 +833,90 @@ ISR (TIMER0_COMPA_vect) {
         static uint8_t busy = 0;
         cnt100us = 0;
         cnt500us++;
+        if (cnt500us & 0x01) {
+            sys.uptimeMs++; // before sei(), so that ISRs interrupting a task read a consistent value
+            sys_setEvent(GLOBAL_EVENT_TICK);
+        }
         if (busy) {
             sys_inc16BitCnt(&sys.err.taskErr_u16);
         } else {
+            uint8_t tick = cnt500us; // SYS_TASK_MAX_PERIOD ticks
             busy = 1;
             sei();
-            if      (cnt500us & 0x01) app_task_1ms();
-            else if (cnt500us & 0x02) {
-                app_task_2ms();
-                sys.adc0_u8 = ADCH;
-                ADCSRA |= (1 << ADSC);
-            
-            } 
-            else if (cnt500us & 0x04) app_task_4ms();
-            else if (cnt500us & 0x08) app_task_8ms();
-            else if (cnt500us & 0x10) app_task_16ms();
-            else if (cnt500us & 0x20) app_task_32ms();
-            else if (cnt500us & 0x40) app_task_64ms();
-            else if (cnt500us & 0x80) app_task_128ms();
+            for (uint8_t i = 0; i < sys_taskCnt; i++) {
+                struct Sys_Task *t = &sys_task[i];
+                if ((tick & t->mask) == t->phase) {
+                    uint16_t start = sys_getTaskTimer();
+                    t->run();
+                    sys_updateTaskTime(SYS_TASKTIME_TASK + i, start);
+                }
+            }
             busy = 0;
         }
     }
 }
 
+// scan of SYS_ADC_SLOTS conversions: slots 0..1 one PT1000 channel, the other slots the 4-20mA
+// channel, so the over-current check gets a conversion at least every 300us
+// the first conversion after a channel switch is not summed up (settling), for the 4-20mA channel
+// it is used by the over-current check (GLOBAL_OVERCURRENT_SAMPLES > 1 ignores a single outlier)
+// 4^GLOBAL_ADC_OVERSAMPLING_BITS samples of a channel are summed up and decimated to SYS_ADC_BITS,
+// the decimated values pass an IIR low pass, then the next PT1000 channel takes slots 0..1
+// ADMUX changes here apply to the next triggered conversion (72us conversion < 100us trigger period)
+ISR (ADC_vect) {
+    uint16_t sample = ADC;
+    uint8_t channel = sys.adc.channel;
+    uint8_t slot = sys.adc.slot;
+    struct Sys_AdcChannel *ch = &sys.adc.ch[channel];
+    if (channel == SYS_ADC_CH_4TO20MA) {
+        sys_checkOvercurrent(sample);
+    }
+    if (slot != 0 && slot != SYS_ADC_SLOT_4TO20MA) {
+        ch->raw = sample;
+        ch->sum += sample;
+        if (++ch->cnt >= (1 << (2 * GLOBAL_ADC_OVERSAMPLING_BITS))) {
+            uint16_t value = ch->sum >> GLOBAL_ADC_OVERSAMPLING_BITS;
+            ch->sum = 0;
+            ch->cnt = 0;
+            ch->value = value;
+            ch->at = sys.uptimeMs;
+            ch->iir += (((int32_t)value << 16) - ch->iir) >> sys.adc.filterShift;
+            ch->filtered = (ch->iir + 0x8000) >> 16;
+            if (channel == SYS_ADC_CH_4TO20MA) {
+                sys_setEvent(GLOBAL_EVENT_ADC);
+            } else if (++sys.adc.pt1000 >= SYS_ADC_CHANNELS) {
+                sys.adc.pt1000 = SYS_ADC_CH_PT1000_1;
+            }
+        }
+    }
+    if (++slot >= SYS_ADC_SLOTS) {
+        slot = 0;
+    }
+    sys.adc.slot = slot;
+    if (slot == 0 || slot == SYS_ADC_SLOT_4TO20MA) {
+        sys.adc.channel = slot == 0 ? sys.adc.pt1000 : SYS_ADC_CH_4TO20MA;
+        ADMUX = (1 << REFS1) | (0 << REFS0) | sys.adc.channel;
+    }
+}
+
+ISR (TIMER1_OVF_vect) {
+    sys.timer1High++;
+}
+
+// S0 energy meter, edges are timestamped here and counted by app
+ISR (PCINT1_vect) {
+    uint32_t t = sys_readTimestamp();
+    uint8_t on = sys_isSensor1On();
+    if (on == sys.sensor1) {
+        return;
+    }
+    sys.sensor1 = on;
+    sys_setLedSensor1(on);
+    app_handleSensor0Edge(on, t);
+}
+
 ISR (TIMER1_COMPA_vect) {
-    TCCR1B = 0;  // disable timer 1
-    // app_handleUart1Timeout();
+    TIMSK1 &= ~(1 << OCIE1A);  // one shot, restarted by next byte
+    modbusRtu_handleFrameGap();
 }
 
@@ -2,11 +2,19 @@
 #define SYS_H_
 
 #include <stdio.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
 
 #include "global.h"
 #if GLOBAL_UART0_RXBUFSIZE > 255
   #error "Error: GLOBAL_UART0_RXBUFSIZE value over maximum (255)"
 #endif
+#if GLOBAL_UART1_TXBUFSIZE > 255
+  #error "Error: GLOBAL_UART1_TXBUFSIZE value over maximum (255)"
+#endif
+#if GLOBAL_ADC_OVERSAMPLING_BITS > 3
+  #error "Error: GLOBAL_ADC_OVERSAMPLING_BITS value over maximum (3)"
+#endif
 
 
 
@@ -16,6 +24,31 @@ typedef unsigned char uint8_t;
 
 typedef uint8_t Sys_Event;
 
+#define SYS_TASKS                  10  // size of timer 0 task table (see sys_addTask)
+#define SYS_TASK_TICK_US          500  // timer 0 task tick
+#define SYS_TASK_MAX_PERIOD       256  // ticks (128ms)
+
+#define SYS_TASKTIME_TASK           0  // slot 0..SYS_TASKS-1: tasks in order of sys_addTask()
+#define SYS_TASKTIME_MODBUS_ASCII   (SYS_TASKS + 0)
+#define SYS_TASKTIME_MODBUS_RTU     (SYS_TASKS + 1)
+#define SYS_TASKTIME_APP            (SYS_TASKS + 2)
+#define SYS_TASKTIME_MODBUS_LATENCY (SYS_TASKS + 3)  // end of request frame until response is queued
+#define SYS_TASKTIME_SLOTS          (SYS_TASKS + 4)
+#define SYS_TASKTIME_BUDGET        ((F_CPU / 8) / 2000)  // 500us, one timer 0 task tick
+#define SYS_TASKTIME_AVG_SHIFT      8
+
+#define SYS_TIMESTAMP_FREQ         (F_CPU / 8)  // TCNT1 extended to 32 bit, wraps after 2863s
+
+#define SYS_ADC_BITS               (10 + GLOBAL_ADC_OVERSAMPLING_BITS)
+#define SYS_ADC_CH_4TO20MA          0  // ADC0, current of 4-20mA output
+#define SYS_ADC_CH_PT1000_1         1  // ADC1
+#define SYS_ADC_CH_PT1000_2         2  // ADC2
+#define SYS_ADC_CHANNELS            3
+#define SYS_ADC_SLOTS               8  // conversions per scan (see ADC_vect)
+#define SYS_ADC_SLOT_4TO20MA        2  // slots 0..1 PT1000, 2..SYS_ADC_SLOTS-1 4-20mA
+
+#define SYS_OVERCURRENT_OFF    0xffff  // level of disabled over-current trip (see sys_setOvercurrentLevel)
+
 
 struct Sys_Uart0_RXBuffer {
     uint8_t rpos_u8;
@@ -36,37 +69,99 @@ struct Sys_Uart0 {
     struct Sys_Uart0_TXBuffer txbuf;
 };
 
+struct Sys_Uart1_TXBuffer {
+    uint8_t rpos_u8;
+    uint8_t wpos_u8;
+    uint8_t buffer_u8[GLOBAL_UART1_TXBUFSIZE];
+};
+
 struct Sys_Uart1 {
     uint8_t errcnt_u8;
     uint8_t fillByte;
+    uint8_t txWait;        // GLOBAL_EVENT_UART1_TX is posted when this number of bytes is free, 0 = off
+    struct Sys_Uart1_TXBuffer txbuf;
 };
 
 struct Sys_ErrorCnt { // size word aligned !
     uint16_t taskErr_u16;
+    uint16_t logDropped_u16;  // log records not stored, ring buffer full
+    uint16_t overcurrent_u16; // over-current trips of 4-20mA output
+};
+
+// binary log (see log.h), sent by USART0_UDRE_vect
+struct Sys_Log {
+    uint8_t rpos;
+    uint8_t wpos;
+    uint8_t buffer[GLOBAL_LOG_BUFSIZE];
+};
+
+// execution time of tasks (timer 0 slots) and main loop modules in TCNT1 ticks (F_CPU/8)
+struct Sys_TaskTime {
+    uint16_t min;
+    uint16_t max;
+    uint16_t avg;       // average of the last (1 << SYS_TASKTIME_AVG_SHIFT) executions
+    uint16_t overrun;   // executions longer than budget of task (main loop: SYS_TASKTIME_BUDGET)
+};
+
+struct Sys_TaskTimes {
+    uint8_t version;
+    uint8_t slots;
+    struct Sys_TaskTime slot[SYS_TASKTIME_SLOTS];
+};
+
+struct Sys_AdcChannel {
+    uint16_t raw;          // last conversion (10 bit)
+    uint16_t value;        // oversampled and decimated (SYS_ADC_BITS)
+    uint16_t filtered;     // value after IIR low pass (SYS_ADC_BITS)
+    int32_t  iir;          // filter state, filtered << 16
+    uint16_t at;           // uptime [ms] (low word) of value
+    uint16_t sum;          // samples of next value
+    uint8_t  cnt;
+};
+
+// ADC conversion started by timer 0 compare match (every 100us)
+// a scan of SYS_ADC_SLOTS conversions holds the 4-20mA channel most of the time (over-current check),
+// the PT1000 channels take turns in slots 0..1, one decimated value each
+struct Sys_Adc {
+    uint8_t  channel;      // channel of the running conversion (selected in ADMUX)
+    uint8_t  slot;         // slot of the running conversion
+    uint8_t  pt1000;       // PT1000 channel of slots 0..1
+    uint8_t  filterShift;  // IIR: y += (x - y) / 2^filterShift, 0 = off
+    struct Sys_AdcChannel ch[SYS_ADC_CHANNELS];
+};
+
+// over-current trip, checked in ADC_vect on every conversion of SYS_ADC_CH_4TO20MA
+// on trip the 4-20mA PWM and all SSRs are switched off and kept off until the fault is cleared
+struct Sys_Overcurrent {
+    uint16_t level;        // raw ADC value (10 bit) tripping, SYS_OVERCURRENT_OFF = disabled
+    uint8_t  cnt;          // consecutive conversions >= level
+    uint8_t  fault;        // latched, cleared by sys_clearOvercurrentFault()
+    uint16_t at;           // uptime [ms] (low word) of trip
 };
 
 struct Sys {
     uint8_t version;
     uint8_t debugLevel;
     struct Sys_ErrorCnt err;
-    uint8_t flags;
     FILE*   fOutModbus;    
-    Sys_Event  eventFlag;
-    uint8_t adc0_u8;
+    struct Sys_Adc adc;
+    struct Sys_Overcurrent overcurrent;
+    uint16_t timer1High;   // upper word of timestamp, incremented on TCNT1 overflow
+    uint32_t uptimeMs;     // incremented in TIMER0_COMPA_vect, wraps after 49 days
+    uint8_t  sensor1;      // last level of PB1 (S0 energy meter)
     struct Sys_Uart0 uart0;
     struct Sys_Uart1 uart1;
+    struct Sys_Log log;
 };
 
 
 // declaration and definations
 
 extern struct Sys sys;
+extern struct Sys_TaskTimes sys_taskTimes;
 
 // defines
 
-// SYS_FLAG_SREG_I must have same position as I-Bit in Status-Register!!
-#define SYS_FLAG_SREG_I          0x80
-
 #define SYS_MODBUS_STATUS_ERR7      7
 #define SYS_MODBUS_STATUS_ERR6      6
 #define SYS_MODBUS_STATUS_ERR5      5
@@ -77,23 +172,45 @@ extern struct Sys sys;
 
 void      sys_init (void);
 void      sys_main (void);
-
-void      sys_sei (void);
-void      sys_cli (void);
+Sys_Event sys_waitForEvents (Sys_Event mask);
 
 void      sys_inc8BitCnt (uint8_t *count);
 void      sys_inc16BitCnt (uint16_t *count);
 
 void      sys_newline (void);
-
-Sys_Event sys_setEvent (Sys_Event event);
-Sys_Event sys_clearEvent (Sys_Event event);
-Sys_Event sys_isEventPending (Sys_Event event);
+void      sys_log (uint8_t id, const uint8_t *data, uint8_t length);
 
 uint8_t   sys_uart0_available ();
 int16_t   sys_uart0_getBufferByte (uint8_t pos);
 void      sys_uart0_flush ();
 
+uint8_t   sys_isUart1TxComplete ();
+uint8_t   sys_getUart1TxFree ();
+void      sys_waitUart1TxFree (uint8_t free);
+void      sys_setUart1Bitrate (uint32_t bitrate);
+void      sys_startUart1Timeout (uint16_t ticks);
+
+uint32_t  sys_getTimestamp (void);
+uint32_t  sys_getUptimeMs (void);
+uint16_t  sys_getTaskTimer (void);
+void      sys_updateTaskTime (uint8_t slot, uint16_t start);
+void      sys_clearTaskTimes (void);
+int8_t    sys_addTask (void (*run)(void), uint16_t period, uint8_t phase, uint16_t budgetUs);
+
+uint16_t  sys_getAdcRaw (void);
+uint16_t  sys_getAdcValue (void);
+uint16_t  sys_getAdcChannel (uint8_t channel);
+uint16_t  sys_getAdcFiltered (void);
+uint16_t  sys_getAdcAt (void);
+uint16_t  sys_getAdcChannelAt (uint8_t channel);
+uint16_t  sys_getAdcFilterShift (void);
+uint8_t   sys_setAdcFilterShift (uint16_t shift);
+
+uint16_t  sys_getOvercurrentLevel (void);
+void      sys_setOvercurrentLevel (uint16_t level);
+uint8_t   sys_isOvercurrentFault (void);
+void      sys_clearOvercurrentFault (void);
+
 void      sys_setSSR (uint8_t index, uint8_t on);
 void      sys_setSSR1 (uint8_t on);
 void      sys_setSSR2 (uint8_t on);
@@ -117,4 +234,43 @@ void      sys_setLedSensor2 (uint8_t on);
 void      sys_toggleLifeLed ();
 void      sys_toggleLedPwmGreen ();
 
+
+// nestable critical section, the I-bit is kept in the caller's local variable
+// uint8_t sreg = sys_enterCritical(); ... sys_leaveCritical(sreg);
+// cli() and the asm in sys_leaveCritical() are memory barriers (as in <util/atomic.h>),
+// so the compiler does not move loads and stores out of the section
+static inline uint8_t sys_enterCritical (void) {
+    uint8_t sreg = SREG;
+    cli();
+    return sreg;
+}
+
+static inline void sys_leaveCritical (uint8_t sreg) {
+    __asm__ __volatile__ ("" ::: "memory");
+    SREG = sreg;
+}
+
+// events are bits of GPIOR0, for a constant event (single bit) the compiler
+// generates sbis/sbi/cbi, so no critical section is needed (main loop and ISR)
+// return value: 1 if event was pending before
+static inline Sys_Event sys_setEvent (Sys_Event event) {
+    if (GPIOR0 & event) {
+        return 1;
+    }
+    GPIOR0 |= event;
+    return 0;
+}
+
+static inline Sys_Event sys_clearEvent (Sys_Event event) {
+    if (GPIOR0 & event) {
+        GPIOR0 &= ~event;
+        return 1;
+    }
+    return 0;
+}
+
+static inline Sys_Event sys_isEventPending (Sys_Event event) {
+    return (GPIOR0 & event) != 0;
+}
+
 #endif // SYS_H_
@@ -60,6 +60,7 @@ export class Controller {
     private _energyTotal:         number;
 
     private _lastRefresh: { at: Date, activePower: number };
+    private _lastWrite: { at: number, setpointPower: number };
     private _timer: NodeJS.Timer;
 
     private constructor (config?: IControllerConfig) {
@@ -283,11 +284,7 @@ export class Controller {
                     msgHeader += 'desiredWatts not valid, set power to 0W';
                     rv = 0;
                 } else {
-                    if (p.desiredWatts > rv) {
-                        rv += 25; // step slowly high to avoid power from grid (slow battery response)
-                    } else {
-                        rv = p.desiredWatts;
-                    }
+                    rv = p.desiredWatts; // firmware ramps up slowly (powerSlewUp) to avoid power from grid
                 }
                 if (rv < min) {
                     rv = min;
@@ -526,8 +523,13 @@ export class Controller {
         }
 
         const hwctrl = HotWaterController.getInstance();
-        await hwctrl.writeActivePower(this._setpointPower);
-        await hwctrl.refresh();
+        if (!hwctrl.isReporting) {
+            await hwctrl.writeActivePowerAndRefresh(this._setpointPower);
+        } else if (!this._lastWrite || this._lastWrite.setpointPower !== this._setpointPower || Date.now() - this._lastWrite.at >= 10000) {
+            // values are updated by change of value reports, write setpoint only on change (and every 10s)
+            await hwctrl.writePowerSetpoint(this._setpointPower);
+            this._lastWrite = { at: Date.now(), setpointPower: this._setpointPower };
+        }
 
         if (hwctrl.activePower.unit === 'W') {
             this._activePower = hwctrl.activePower.value;
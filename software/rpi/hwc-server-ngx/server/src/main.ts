@@ -213,6 +213,11 @@ async function startupInSequence (): Promise<any []> {
     let p: Promise<any>;
     for (const ms of modbusSerials) {
         p = ms.open(serialDevices[ms.device]); await p; rv.push(p);
+        for (const d of serialDevices[ms.device] || []) {
+            if (d instanceof HotWaterController) {
+                await d.startReports();
+            }
+        }
     }
     p = Controller.createInstance(); await p; rv.push(p);
     await Controller.getInstance().start();
@@ -10,6 +10,7 @@ import { ModbusSerial } from './modbus-serial';
 import { ModbusFrame } from './modbus-frame';
 import { ModbusRequest, ModbusRequestFactory } from './modbus-request';
 import { ModbusSerialDevice, IModbusSerialDeviceConfig } from './modbus-serial-device';
+import { HwcRegister, IHwcRegister, IHwcRegisterValues } from './hwc-register';
 import { Value, IValue } from '../data/common/hwc/value';
 
 
@@ -19,6 +20,34 @@ export interface IHotWaterControllerValues {
     current4To20mA: IValue;  // measured, floating point value 0.0 ... 20.0 mA
 }
 
+// opt-in change of value reports (only for a dedicated point-to-point link)
+export interface IHotWaterControllerReportConfig {
+    disabled?: boolean;
+    intervalMillis: number;       // max. time between two reports (>= 100)
+    powerDeadbandWatts: number;   // report if power moves more than this value
+    tempDeadbandCelsius: number;  // report if a PT1000 temperature moves more than this value
+}
+
+export interface IHotWaterControllerConfig extends IModbusSerialDeviceConfig {
+    report?: IHotWaterControllerReportConfig;
+}
+
+export interface IHotWaterControllerTaskTime {
+    name: string;        // firmware task or main loop module
+    minMicros: number;   // NaN if not executed since reset of statistics
+    maxMicros: number;
+    avgMicros: number;
+    overrun: number;     // executions longer than budget (tasks) or 500us (main loop)
+}
+
+
+export interface IHotWaterControllerSample {
+    seq: number;             // 0..255, gaps show samples lost in firmware fifo
+    current4To20mA: number;  // measured (not filtered) [mA]
+    setpoint4To20mA: number; // [mA]
+    sensor0Cnt: number;      // low byte of S0 pulse counter
+}
+
 
 export class HotWaterController extends ModbusSerialDevice implements IHotWaterControllerValues {
 
@@ -27,16 +56,22 @@ export class HotWaterController extends ModbusSerialDevice implements IHotWaterC
         return this._instance;
     }
 
-    public static async createInstance (serial: ModbusSerial, config: IModbusSerialDeviceConfig) {
+    public static async createInstance (serial: ModbusSerial, config: IHotWaterControllerConfig) {
         if (this._instance) { throw new Error('instance already created'); }
         this._instance = new HotWaterController(serial, config);
         return this._instance;
     }
 
     private static _instance: HotWaterController;
-    private static powerTable: { [ current: number ]: number } = {
-        6: 2.8, 7: 5.7, 8: 26, 9: 48, 10: 122, 11: 257, 12: 460, 13: 716, 14: 1045, 15: 1292, 16: 1553, 17: 1730, 18: 1870, 19: 1935, 20: 1950
-    };
+    private static taskTimeAddr = 0x1800;
+    // task table slots in order of registration (app_init), followed by the main loop slots
+    private static taskTimeNames = [
+        'app_task_1ms', 'app_task_2ms', 'app_task_4ms', 'app_task_8ms', 'app_task_16ms', 'app_task_32ms', 'app_task_64ms',
+        'app_task_128ms'
+    ];
+    private static mainLoopTimeNames = [ 'modbusAscii_main', 'modbusRtu_main', 'app_main', 'modbus_latency' ];
+    // same registers as the reports of the firmware (setpoint4To20mA ... fault)
+    private static refreshQuantity = HwcRegister.fault.addr + HwcRegister.fault.words - HwcRegister.setpoint4To20mA.addr;
 
 
     // *****************************************************************
@@ -48,15 +83,23 @@ export class HotWaterController extends ModbusSerialDevice implements IHotWaterC
     private _setpoint4To20mA: Value;
     private _current4To20mA: Value;
     private _activePower: Value;
+    private _pt1000Temp: Value [];
     private _energyMeter: { at: Date, timer: number, s0Count: number };
+    private _register: IHwcRegisterValues;
+    private _isReporting = false;
+    private _lastReportAt = 0;
+    private _fault = 0;
+    private _clock: { offsetMillis: number, rttMillis: number, at: number }; // Date.now() = firmware uptime + offsetMillis
 
-    private constructor (serial: ModbusSerial, config: IModbusSerialDeviceConfig) {
+    private constructor (serial: ModbusSerial, config: IHotWaterControllerConfig) {
         super(serial, config);
         this._eventEmitter = new EventEmitter();
         this._setpoint4To20mA = this.createValue(Number.NaN, 'mA');
         this._current4To20mA = this.createValue(Number.NaN, 'mA');
         this._activePower = this.createValue(Number.NaN, 'W');
+        this._pt1000Temp = [ this.createValue(Number.NaN, '°C'), this.createValue(Number.NaN, '°C') ];
         this._energyMeter = { at: new Date(), timer: 0xffff, s0Count: 0 };
+        this._register = HwcRegister.createValues();
     }
 
     public on (event: 'update', listener: (values: IHotWaterControllerValues) => void) {
@@ -69,68 +112,178 @@ export class HotWaterController extends ModbusSerialDevice implements IHotWaterC
         return this;
     }
 
-    public get config (): IModbusSerialDeviceConfig {
-        return <IModbusSerialDeviceConfig>super.config;
+    public get config (): IHotWaterControllerConfig {
+        return <IHotWaterControllerConfig>super.config;
+    }
+
+    public get baudRateRegister (): number {
+        return HwcRegister.uart1Bitrate.addr;
     }
 
     public async refresh () {
-        await this.readHoldRegister(1, 5);
-    }
-
-    public async readHoldRegister(startAddress: number, quantity: number) {
-        const requ =  ModbusRequestFactory.createReadHoldRegister(this.config.slaveAddress, startAddress, quantity);
-        const mr = await this.serial.send(requ, this.config.timeoutMillis);
-        const energyMeter: { at: Date, timer: number, s0Count: number } = { at: new Date(), timer: null, s0Count: 0 };
-        for (let i = 0; i < quantity; i++) {
-            const v = Math.round(mr.response.wordAt(3 + i * 2));
-            switch ( startAddress + i) {
-                case 1: this._setpoint4To20mA = this.createValue(Math.round(v / 2048 * 100) / 100, 'mA'); break;
-                case 2: {
-                    this._current4To20mA = this.createValue(Math.round(v / 2048 * 100) / 100, 'mA' );
-                    // this._activePower = this.createValue(this.currentMilliAmpsToPowerWatts(v / 2048), 'W' );
-                    break;
-                }
-                case 3: energyMeter.timer = v; break;
-                case 4: energyMeter.s0Count += (v * 65536); break;
-                case 5: energyMeter.s0Count += v; break;
-                default: debug.warn('hold register addr %d not handled', startAddress + i);
-            }
+        await this.readHoldRegister(HwcRegister.setpoint4To20mA.addr, HotWaterController.refreshQuantity);
+    }
+
+    // addr: protocol address (0-based) like in HwcRegister
+    public async readHoldRegister(addr: number, quantity: number) {
+        const requ =  ModbusRequestFactory.createReadHoldRegister(this.config.slaveAddress, addr + 1, quantity);
+        const mr = await this.serial.send(requ, this.config.timeoutMillis, this.protocol);
+        this.handleHoldRegisterValues(mr.response.buffer, addr, quantity, mr);
+    }
+
+    // enables change of value reports in firmware if configured, values are updated without polling then
+    public async startReports () {
+        const r = this.config.report;
+        if (!r || r.disabled) {
+            return;
         }
-        // debug.fine('---> energyMeter: %o', energyMeter);
-        if (energyMeter.timer >= 0 && energyMeter.timer <= 0xffff && energyMeter.s0Count >= 0) {
-            this._energyMeter = energyMeter;
-            if (this._energyMeter.timer === 0xffff) {
-                this._activePower = this.createValue(0, 'W');
-            } else {
-                this._activePower = this.createValue(Math.round(250 * 3600 / this._energyMeter.timer * 10) / 10, 'W');
-            }
-        } else {
-            this._activePower = this.createValue(Number.NaN, 'W');
+        if (!(r.intervalMillis >= 100 && r.intervalMillis <= 0xffff && r.powerDeadbandWatts >= 0 && r.tempDeadbandCelsius >= 0)) {
+            throw new Error('invalid report configuration ' + JSON.stringify(r));
         }
+        await this.readHoldRegister(HwcRegister.uptime.addr, HwcRegister.uptime.words); // clock offset for report timestamps
+        const values = [ Math.round(r.intervalMillis), Math.round(r.powerDeadbandWatts), Math.round(r.tempDeadbandCelsius * 100) ];
+        const requ = ModbusRequestFactory.createWriteMultipleHoldRegisters(
+            this.config.slaveAddress, HwcRegister.reportInterval.addr + 1, values.length, values);
+        await this.serial.send(requ, this.config.timeoutMillis, this.protocol);
+        this._isReporting = true;
+        this._lastReportAt = Date.now();
+        debug.info('change of value reports started (%o)', r);
+    }
+
+    // the firmware reports at least every intervalMillis, without report for 2 intervals (reset of
+    // the firmware) values are polled again and the reports are restarted in background
+    public get isReporting (): boolean {
+        if (this._isReporting && Date.now() - this._lastReportAt > 2 * this.config.report.intervalMillis) {
+            debug.warn('no report since %dms -> polling, restart reports', Date.now() - this._lastReportAt);
+            this._isReporting = false;
+            this.startReports().catch( (err) => debug.warn('restart of reports fails\n%e', err) );
+        }
+        return this._isReporting;
+    }
+
+    public async handleTargetReset () {
+        this._isReporting = false;
+        await this.startReports();
+    }
+
+    // report frame: address, function code, byte count, registers starting at protocol address 0
+    public handleReport (f: ModbusFrame) {
+        const quantity = f.byteAt(2) / 2;
+        if (!(quantity >= 1) || f.buffer.length < 3 + quantity * 2) {
+            debug.warn('invalid report frame %o', f.buffer);
+            return;
+        }
+        debug.finer('report received (%d registers)', quantity);
+        this._lastReportAt = Date.now();
+        this.handleHoldRegisterValues(f.buffer, 0, quantity);
+    }
+
+    // writes power setpoint without reading back, used when values are received by reports
+    public async writePowerSetpoint (powerWatts: number) {
+        if (!(powerWatts >= 0 && powerWatts < 0xffff)) {
+            throw new Error('illegal value ' + powerWatts);
+        }
+        const value = Math.round(powerWatts);
+        const requ = ModbusRequestFactory.createWriteHoldRegister(this.config.slaveAddress, HwcRegister.powerSetpoint.addr + 1, value);
+        debug.finer('powerSetpoint: write %d', value);
+        await this.serial.send(requ, this.config.timeoutMillis, this.protocol);
+    }
+
+    // writes power setpoint (converted and ramped by firmware) and reads back setpoint, current,
+    // energy meter, temperatures, power and faults in one transaction (function code 0x17)
+    public async writeActivePowerAndRefresh (powerWatts: number) {
+        if (!(powerWatts >= 0 && powerWatts < 0xffff)) {
+            throw new Error('illegal value ' + powerWatts);
+        }
+        const value = Math.round(powerWatts);
+        const addr = HwcRegister.setpoint4To20mA.addr;
+        const requ = ModbusRequestFactory.createReadWriteMultipleHoldRegisters(
+            this.config.slaveAddress, addr + 1, HotWaterController.refreshQuantity, HwcRegister.powerSetpoint.addr + 1, [ value ]);
+        debug.finer('powerSetpoint: write %d', value);
+        const mr = await this.serial.send(requ, this.config.timeoutMillis, this.protocol);
+        this.handleHoldRegisterValues(mr.response.buffer, addr, HotWaterController.refreshQuantity, mr);
     }
 
     public async readCurrent4To20mA () {
-        await this.readHoldRegister(2, 1);
+        await this.readHoldRegister(HwcRegister.current4To20mA.addr, 1);
         if (debug.finer.enabled) {
             debug.finer('current = %s', sprintf('%.2d%s', this. _current4To20mA.value, this. _current4To20mA.unit));
         }
     }
 
     public async writeCurrent4To20mA (value: number) {
-        const id = 0;
-        const quantity = 1;
         if (!(value >= 0 && (value * 2048) <= 0xffff)) {
             throw new Error('illegal value ' + value);
         }
         value = value * 2048;
-        const requ =  ModbusRequestFactory.createWriteHoldRegister(this.config.slaveAddress, id + 1, value);
+        const requ =  ModbusRequestFactory.createWriteHoldRegister(this.config.slaveAddress, HwcRegister.setpoint4To20mA.addr + 1, value);
         debug.finer('current4To20mA: write setpoint %d', value);
-        const mr = await this.serial.send(requ, this.config.timeoutMillis);
+        const mr = await this.serial.send(requ, this.config.timeoutMillis, this.protocol);
     }
 
-    public async writeActivePower (powerWatts: number) {
-        const millis = this.powerWattsToCurrentMilliAmps(powerWatts);
-        await this.writeCurrent4To20mA(millis);
+    // execution times measured by firmware (register window 0x1800, TCNT1 ticks = 1/1.5MHz)
+    public async readTaskTimes (): Promise<IHotWaterControllerTaskTime []> {
+        // register 2: version (low byte) and number of slots (high byte), then min/max/avg/overrun per slot
+        const words: number [] = [];
+        let quantity = 3;
+        while (words.length < quantity) {
+            const n = Math.min(quantity - words.length, 125);
+            const requ = ModbusRequestFactory.createReadHoldRegister(this.config.slaveAddress, HotWaterController.taskTimeAddr + words.length + 1, n);
+            const mr = await this.serial.send(requ, this.config.timeoutMillis, this.protocol);
+            for (let i = 0; i < n; i++) {
+                words.push(mr.response.wordAt(3 + i * 2));
+            }
+            if (words.length === 3) {
+                /* tslint:disable-next-line:no-bitwise */
+                quantity = 3 + (words[2] >> 8) * 4;
+            }
+        }
+        const rv: IHotWaterControllerTaskTime [] = [];
+        const tasks = (quantity - 3) / 4 - HotWaterController.mainLoopTimeNames.length;
+        for (let i = 0; i < (quantity - 3) / 4; i++) {
+            const w = words.slice(3 + i * 4, 7 + i * 4);
+            const name = i >= tasks ? HotWaterController.mainLoopTimeNames[i - tasks] : (HotWaterController.taskTimeNames[i] || 'task' + i);
+            rv.push({
+                name:      name,
+                minMicros: w[0] === 0xffff ? Number.NaN : Math.round(w[0] / 1.5),
+                maxMicros: Math.round(w[1] / 1.5),
+                avgMicros: Math.round(w[2] / 1.5),
+                overrun:   w[3]
+            });
+        }
+        return rv;
+    }
+
+    // drains the firmware sample fifo (function code 0x18), enable sampling with register sampleDivider
+    public async readSamples (): Promise<IHotWaterControllerSample []> {
+        const rv: IHotWaterControllerSample [] = [];
+        // firmware fifo holds 64 samples, max. 9 samples per response, limit requests if sampling is faster than reading
+        for (let n = 0; n < 8; n++) {
+            const requ = ModbusRequestFactory.createReadFifoQueue(this.config.slaveAddress, HwcRegister.sampleFifo.addr + 1);
+            const mr = await this.serial.send(requ, this.config.timeoutMillis, this.protocol);
+            const words = mr.response.wordAt(4);
+            for (let i = 0; i + 3 <= words; i += 3) {
+                const o = 6 + i * 2;
+                /* tslint:disable:no-bitwise */
+                const w = mr.response.wordAt(o + 4);
+                rv.push({
+                    seq:             w >> 8,
+                    current4To20mA:  mr.response.wordAt(o) / 2048,
+                    setpoint4To20mA: mr.response.wordAt(o + 2) / 2048,
+                    sensor0Cnt:      w & 0xff
+                });
+                /* tslint:enable:no-bitwise */
+            }
+            if (words < 3) {
+                break;
+            }
+        }
+        return rv;
+    }
+
+    public async clearTaskTimes () {
+        const requ = ModbusRequestFactory.createWriteHoldRegister(this.config.slaveAddress, HotWaterController.taskTimeAddr + 2 + 1, 0);
+        await this.serial.send(requ, this.config.timeoutMillis, this.protocol);
     }
 
     public get lastUpdateAt (): Date {
@@ -149,6 +302,20 @@ export class HotWaterController extends ModbusSerialDevice implements IHotWaterC
         return this._activePower;
     }
 
+    // PT1000 temperatures measured by firmware, NaN if sensor open or shorted
+    public get pt1000Temp1 (): Value {
+        return this._pt1000Temp[0];
+    }
+
+    public get pt1000Temp2 (): Value {
+        return this._pt1000Temp[1];
+    }
+
+    // estimated by responses containing register uptime, undefined if not known yet
+    public get firmwareClock (): { offsetMillis: number, rttMillis: number, at: number } {
+        return this._clock;
+    }
+
     public get energyMeter (): { at: Date, timer: number, s0Count: number } {
         return this._energyMeter;
     }
@@ -162,73 +329,99 @@ export class HotWaterController extends ModbusSerialDevice implements IHotWaterC
         return rv;
     }
 
-    private createValue (value: number, unit: string): Value {
-        return new Value({
-            createdAt: Date.now(),
-            createdFrom: 'HotWaterController',
-            value: value,
-            unit: unit
-        });
+    // buffer: response or report frame, byte count at offset 2, register values from offset 3
+    // mr: request of the response, used for clock offset estimation
+    private handleHoldRegisterValues (buffer: Buffer, addr: number, quantity: number, mr?: ModbusRequest) {
+        HwcRegister.decode(this._register, buffer, 3, addr, quantity);
+        if (mr && addr <= HwcRegister.uptime.addr && addr + quantity >= HwcRegister.uptime.addr + HwcRegister.uptime.words) {
+            this.updateClock(mr);
+        }
+        this.updateValues(addr, quantity);
+        this._lastUpdateAt = new Date();
+        this._eventEmitter.emit('update', this.toValuesObject());
     }
 
-    private currentMilliAmpsToPowerWatts (currentMilliAmps: number): number {
-        if (typeof (currentMilliAmps) !== 'number' || Number.isNaN(currentMilliAmps)) {
-            debug.warn('invalid currentMilliAmps %s', currentMilliAmps);
-            return 0;
-        } else if (currentMilliAmps < 7) {
-            return 0;
-        } else if (currentMilliAmps > 20) {
-            return HotWaterController.powerTable[20];
-        } else {
-            const p1 = HotWaterController.powerTable[Math.floor(currentMilliAmps)];
-            const p2 = HotWaterController.powerTable[Math.floor(currentMilliAmps) + 1];
-            const p = p1 + (p2 - p1) * (currentMilliAmps - Math.floor(currentMilliAmps));
-            if (p < 0 || p > 2000) {
-                debug.warn('invalid power value %f', p);
-                return 0;
-            } else {
-                return p;
-            }
+    // uptime is latched between reception of request and sending of response, so the middle of the
+    // round trip is used; the estimation with the smallest round trip time wins (renewed after 60s)
+    private updateClock (mr: ModbusRequest) {
+        const uptime = this._register.uptime;
+        if (!(uptime >= 0) || !mr.sentAt || !mr.responseAt) {
+            return;
+        }
+        const now = Date.now();
+        const rtt = mr.responseAt.getTime() - mr.sentAt.getTime();
+        const offset = (mr.sentAt.getTime() + mr.responseAt.getTime()) / 2 - uptime;
+        const c = this._clock;
+        if (!c || rtt <= c.rttMillis || now - c.at > 60000 || Math.abs(offset - c.offsetMillis) > 1000) {
+            this._clock = { offsetMillis: Math.round(offset), rttMillis: rtt, at: now };
+            debug.finer('firmware clock offset %dms (rtt %dms)', this._clock.offsetMillis, rtt);
         }
     }
 
-    private powerWattsToCurrentMilliAmps (powerWatts: number): number {
-        if (typeof (powerWatts) !== 'number' || Number.isNaN(powerWatts)) {
-            debug.warn('invalid powerWatts %s', powerWatts);
-            return 0;
-        } else if (powerWatts <= HotWaterController.powerTable[6]) {
-            return 0;
-        } else if (powerWatts >= HotWaterController.powerTable[20]) {
-            return 20;
-        } else {
-            for (let i = 6; i <= 19; i++) {
-                const p1 = HotWaterController.powerTable[i];
-                const p2 = HotWaterController.powerTable[i + 1];
-                if (powerWatts >= p1 && powerWatts <= p2) {
-                    const k = p2 - p1;
-                    const d = p1 - k * i;
-                    const curr = Math.round((powerWatts - d) / k * 100) / 100;
-                    if (curr < 0 || curr > 20) {
-                        debug.warn('calculation error (current=%f) from power value %f', curr, powerWatts);
-                        return 0;
-                    }
-                    return curr;
-                }
+    // firmware timestamp (low word of uptime) of a value in block addr..end to host time,
+    // undefined if timestamp or uptime not in block or clock offset not known
+    private firmwareTime (addr: number, end: number, reg: IHwcRegister, lowWordMillis: number): number {
+        if (!this._clock || addr > reg.addr || end <= reg.addr ||
+            addr > HwcRegister.uptime.addr || end < HwcRegister.uptime.addr + HwcRegister.uptime.words) {
+            return undefined;
+        }
+        const uptime = this._register.uptime;
+        /* tslint:disable-next-line:no-bitwise */
+        const age = (uptime - lowWordMillis) & 0xffff;
+        return uptime - age + this._clock.offsetMillis;
+    }
+
+    private updateValues (addr: number, quantity: number) {
+        const r = this._register;
+        const end = addr + quantity;
+        if (addr <= HwcRegister.setpoint4To20mA.addr && end > HwcRegister.setpoint4To20mA.addr) {
+            this._setpoint4To20mA = this.createValue(Math.round(r.setpoint4To20mA * 100) / 100, HwcRegister.setpoint4To20mA.unit);
+        }
+        if (addr <= HwcRegister.current4To20mA.addr && end > HwcRegister.current4To20mA.addr) {
+            this._current4To20mA = this.createValue(Math.round(r.current4To20mA * 100) / 100, HwcRegister.current4To20mA.unit,
+                                                    this.firmwareTime(addr, end, HwcRegister.adcAt, r.adcAt));
+        }
+        const ptAt = this.firmwareTime(addr, end, HwcRegister.pt1000At, r.pt1000At);
+        if (addr <= HwcRegister.pt1000Temp1.addr && end > HwcRegister.pt1000Temp1.addr) {
+            this._pt1000Temp[0] = this.createValue(Math.round(r.pt1000Temp1 * 10) / 10, HwcRegister.pt1000Temp1.unit, ptAt);
+        }
+        if (addr <= HwcRegister.pt1000Temp2.addr && end > HwcRegister.pt1000Temp2.addr) {
+            this._pt1000Temp[1] = this.createValue(Math.round(r.pt1000Temp2 * 10) / 10, HwcRegister.pt1000Temp2.unit, ptAt);
+        }
+        if (addr <= HwcRegister.fault.addr && end > HwcRegister.fault.addr && r.fault !== this._fault) {
+            if (r.fault > 0) {
+                debug.warn('firmware fault %d latched (bit 0: over-current trip), 4-20mA output and SSRs off', r.fault);
             }
-            debug.warn('cannot calculate current from power value %f', powerWatts);
-            for (let i = 6; i <= 19; i++) {
-                const p1 = HotWaterController.powerTable[i];
-                const p2 = HotWaterController.powerTable[i + 1];
-                debug.info('---> i=%d, p1=%d p2=%d', i, p1, p2);
-                if (powerWatts >= p1 && powerWatts <= p2) {
-                    const k = p2 - p1;
-                    const d = p1 - k * i;
-                    const curr = Math.round((powerWatts - d) / k * 100) / 100;
-                    debug.info('--------> curr=%d', curr);
-                }
+            this._fault = r.fault;
+        }
+        if (addr > HwcRegister.sensor0Time.addr || end < HwcRegister.sensor0Cnt.addr + HwcRegister.sensor0Cnt.words) {
+            return;
+        }
+        // debug.fine('---> energyMeter: %o', r);
+        if (r.sensor0Time >= 0 && r.sensor0Time <= 0xffff && r.sensor0Cnt >= 0) {
+            this._energyMeter = { at: new Date(), timer: r.sensor0Time, s0Count: r.sensor0Cnt };
+            if (addr <= HwcRegister.sensor0Power.addr && end > HwcRegister.sensor0Power.addr && r.sensor0Power >= 0) {
+                // firmware average over pulse timestamps of the last 10s
+                this._activePower = this.createValue(Math.round(r.sensor0Power * 10) / 10, HwcRegister.sensor0Power.unit,
+                                                     r.sensor0Cnt > 0 ? this.firmwareTime(addr, end, HwcRegister.sensor0PulseAt, r.sensor0PulseAt) : undefined);
+            } else if (this._energyMeter.timer === 0xffff) {
+                this._activePower = this.createValue(0, 'W');
+            } else {
+                this._activePower = this.createValue(Math.round(250 * 3600 / this._energyMeter.timer * 10) / 10, 'W');
             }
-            return 0;
+        } else {
+            this._activePower = this.createValue(Number.NaN, 'W');
         }
     }
 
+    // at: firmware timestamp converted to host time (see firmwareTime), Date.now() if undefined
+    private createValue (value: number, unit: string, at?: number): Value {
+        return new Value({
+            createdAt: at >= 0 ? at : Date.now(),
+            createdFrom: 'HotWaterController',
+            value: value,
+            unit: unit
+        });
+    }
+
 }
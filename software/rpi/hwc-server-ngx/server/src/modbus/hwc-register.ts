@@ -0,0 +1,212 @@
+// generated by modbus_register.js from modbus_register.json, do not edit
+
+export interface IHwcRegisterValues {
+    setpoint4To20mA: number;      // [mA] setpoint of 4-20mA output
+    current4To20mA: number;       // [mA] measured current of 4-20mA output
+    sensor0Time: number;          // time between the last two S0 pulses, 0xffff if no pulse
+    sensor0Cnt: number;           // S0 pulse counter, reading the high word latches the low word
+    modbusMode: number;           // Modbus framing, 0=auto, 1=ASCII, 2=RTU
+    adcRaw: number;               // 4-20mA input, last ADC conversion (10 bit)
+    adcValue: number;             // 4-20mA input, oversampled and decimated (12/13 bit)
+    adcFiltered: number;          // 4-20mA input, adcValue after IIR low pass
+    adcFilterShift: number;       // IIR low pass y += (x - y) / 2^n, 0..8, 0 = off
+    pt1000Temp1: number;          // [°C] temperature of PT1000-1, 0x8000 if sensor open or shorted
+    pt1000Temp2: number;          // [°C] temperature of PT1000-2, 0x8000 if sensor open or shorted
+    sensor0Power: number;         // [W] active power from S0 pulse timestamps, averaged over the last 10s
+    control4To20mA: number;       // 4-20mA output, 0=open loop, 1=closed loop (PI), 2=closed loop saturated (read only)
+    powerSetpoint: number;        // [W] power setpoint, converted by power table (0x1c00), 0xffff if setpoint4To20mA written
+    powerRamp: number;            // [W] power setpoint after slew rate limitation
+    powerSlewUp: number;          // [W/s] max. increase of powerRamp, 0 = unlimited
+    powerSlewDown: number;        // [W/s] max. decrease of powerRamp, 0 = unlimited
+    sampleDivider: number;        // sample fifo, one sample every n * 2ms (max. 255), 0 = off
+    sampleFifo: number;           // samples in fifo, FIFO pointer address for FC 0x18 (current, setpoint, seq/sensor0Cnt)
+    sampleLost: number;           // samples not stored because fifo was full
+    reportInterval: number;       // [ms] change of value reports (FC 0x41, registers 0..28), max. time between reports (>= 100), 0 = off
+    reportPowerDeadband: number;  // [W] report if sensor0Power or powerRamp moves more than this value
+    reportTempDeadband: number;   // [°C] report if pt1000Temp1 or pt1000Temp2 moves more than this value
+    uptime: number;               // [ms] milliseconds since reset, reading the high word latches the low word
+    adcAt: number;                // [ms] uptime (low word) of last adcValue
+    pt1000At: number;             // [ms] uptime (low word) of ADC values used for pt1000Temp1/2
+    sensor0PulseAt: number;       // [ms] uptime (low word) of last S0 pulse
+    uart1Bitrate: number;         // UART1 bit rate / 100 (1152, 5000, 7500, 15000), switched after the response, falls back to 1152 without valid frames
+    overcurrentTrip: number;      // [mA] trip level of 4-20mA output current (4..29mA), 0 = off, checked on every ADC conversion
+    fault: number;                // latched faults, bit 0: over-current trip (PWM and SSRs off), write 0 to clear (sets 4-20mA setpoint to 0)
+}
+
+export interface IHwcRegister {
+    addr: number;   // protocol address (0-based)
+    words: number;
+    scale: number;
+    unit: string;
+}
+
+export class HwcRegister {
+
+    public static readonly setpoint4To20mA: IHwcRegister = { addr: 0, words: 1, scale: 2048, unit: 'mA' };
+    public static readonly current4To20mA: IHwcRegister = { addr: 1, words: 1, scale: 2048, unit: 'mA' };
+    public static readonly sensor0Time: IHwcRegister = { addr: 2, words: 1, scale: 1, unit: null };
+    public static readonly sensor0Cnt: IHwcRegister = { addr: 3, words: 2, scale: 1, unit: null };
+    public static readonly modbusMode: IHwcRegister = { addr: 5, words: 1, scale: 1, unit: null };
+    public static readonly adcRaw: IHwcRegister = { addr: 6, words: 1, scale: 1, unit: null };
+    public static readonly adcValue: IHwcRegister = { addr: 7, words: 1, scale: 1, unit: null };
+    public static readonly adcFiltered: IHwcRegister = { addr: 8, words: 1, scale: 1, unit: null };
+    public static readonly adcFilterShift: IHwcRegister = { addr: 9, words: 1, scale: 1, unit: null };
+    public static readonly pt1000Temp1: IHwcRegister = { addr: 10, words: 1, scale: 100, unit: '°C' };
+    public static readonly pt1000Temp2: IHwcRegister = { addr: 11, words: 1, scale: 100, unit: '°C' };
+    public static readonly sensor0Power: IHwcRegister = { addr: 12, words: 1, scale: 10, unit: 'W' };
+    public static readonly control4To20mA: IHwcRegister = { addr: 13, words: 1, scale: 1, unit: null };
+    public static readonly powerSetpoint: IHwcRegister = { addr: 14, words: 1, scale: 1, unit: 'W' };
+    public static readonly powerRamp: IHwcRegister = { addr: 15, words: 1, scale: 1, unit: 'W' };
+    public static readonly powerSlewUp: IHwcRegister = { addr: 16, words: 1, scale: 1, unit: 'W/s' };
+    public static readonly powerSlewDown: IHwcRegister = { addr: 17, words: 1, scale: 1, unit: 'W/s' };
+    public static readonly sampleDivider: IHwcRegister = { addr: 18, words: 1, scale: 1, unit: null };
+    public static readonly sampleFifo: IHwcRegister = { addr: 19, words: 1, scale: 1, unit: null };
+    public static readonly sampleLost: IHwcRegister = { addr: 20, words: 1, scale: 1, unit: null };
+    public static readonly reportInterval: IHwcRegister = { addr: 21, words: 1, scale: 1, unit: 'ms' };
+    public static readonly reportPowerDeadband: IHwcRegister = { addr: 22, words: 1, scale: 1, unit: 'W' };
+    public static readonly reportTempDeadband: IHwcRegister = { addr: 23, words: 1, scale: 100, unit: '°C' };
+    public static readonly uptime: IHwcRegister = { addr: 24, words: 2, scale: 1, unit: 'ms' };
+    public static readonly adcAt: IHwcRegister = { addr: 26, words: 1, scale: 1, unit: 'ms' };
+    public static readonly pt1000At: IHwcRegister = { addr: 27, words: 1, scale: 1, unit: 'ms' };
+    public static readonly sensor0PulseAt: IHwcRegister = { addr: 28, words: 1, scale: 1, unit: 'ms' };
+    public static readonly uart1Bitrate: IHwcRegister = { addr: 29, words: 1, scale: 1, unit: null };
+    public static readonly overcurrentTrip: IHwcRegister = { addr: 30, words: 1, scale: 2048, unit: 'mA' };
+    public static readonly fault: IHwcRegister = { addr: 31, words: 1, scale: 1, unit: null };
+    public static readonly size = 32;
+
+    public static createValues (): IHwcRegisterValues {
+        return {
+            setpoint4To20mA: Number.NaN,
+            current4To20mA: Number.NaN,
+            sensor0Time: Number.NaN,
+            sensor0Cnt: Number.NaN,
+            modbusMode: Number.NaN,
+            adcRaw: Number.NaN,
+            adcValue: Number.NaN,
+            adcFiltered: Number.NaN,
+            adcFilterShift: Number.NaN,
+            pt1000Temp1: Number.NaN,
+            pt1000Temp2: Number.NaN,
+            sensor0Power: Number.NaN,
+            control4To20mA: Number.NaN,
+            powerSetpoint: Number.NaN,
+            powerRamp: Number.NaN,
+            powerSlewUp: Number.NaN,
+            powerSlewDown: Number.NaN,
+            sampleDivider: Number.NaN,
+            sampleFifo: Number.NaN,
+            sampleLost: Number.NaN,
+            reportInterval: Number.NaN,
+            reportPowerDeadband: Number.NaN,
+            reportTempDeadband: Number.NaN,
+            uptime: Number.NaN,
+            adcAt: Number.NaN,
+            pt1000At: Number.NaN,
+            sensor0PulseAt: Number.NaN,
+            uart1Bitrate: Number.NaN,
+            overcurrentTrip: Number.NaN,
+            fault: Number.NaN
+        };
+    }
+
+    // decodes quantity register words (starting with protocol address addr) from buffer[offset...] into values
+    // values are divided by scale, invalid values are decoded as NaN
+    // registers not completely covered by the block are not modified
+    public static decode (values: IHwcRegisterValues, buffer: Buffer, offset: number, addr: number, quantity: number) {
+        const end = addr + quantity;
+        if (addr <= 0 && end >= 1) {
+            values.setpoint4To20mA = buffer.readUInt16BE(offset + (0 - addr) * 2) / 2048;
+        }
+        if (addr <= 1 && end >= 2) {
+            values.current4To20mA = buffer.readUInt16BE(offset + (1 - addr) * 2) / 2048;
+        }
+        if (addr <= 2 && end >= 3) {
+            values.sensor0Time = buffer.readUInt16BE(offset + (2 - addr) * 2);
+        }
+        if (addr <= 3 && end >= 5) {
+            values.sensor0Cnt = buffer.readUInt32BE(offset + (3 - addr) * 2);
+        }
+        if (addr <= 5 && end >= 6) {
+            values.modbusMode = buffer.readUInt16BE(offset + (5 - addr) * 2);
+        }
+        if (addr <= 6 && end >= 7) {
+            values.adcRaw = buffer.readUInt16BE(offset + (6 - addr) * 2);
+        }
+        if (addr <= 7 && end >= 8) {
+            values.adcValue = buffer.readUInt16BE(offset + (7 - addr) * 2);
+        }
+        if (addr <= 8 && end >= 9) {
+            values.adcFiltered = buffer.readUInt16BE(offset + (8 - addr) * 2);
+        }
+        if (addr <= 9 && end >= 10) {
+            values.adcFilterShift = buffer.readUInt16BE(offset + (9 - addr) * 2);
+        }
+        if (addr <= 10 && end >= 11) {
+            const v = buffer.readInt16BE(offset + (10 - addr) * 2);
+            values.pt1000Temp1 = v === -32768 ? Number.NaN : v / 100;
+        }
+        if (addr <= 11 && end >= 12) {
+            const v = buffer.readInt16BE(offset + (11 - addr) * 2);
+            values.pt1000Temp2 = v === -32768 ? Number.NaN : v / 100;
+        }
+        if (addr <= 12 && end >= 13) {
+            values.sensor0Power = buffer.readUInt16BE(offset + (12 - addr) * 2) / 10;
+        }
+        if (addr <= 13 && end >= 14) {
+            values.control4To20mA = buffer.readUInt16BE(offset + (13 - addr) * 2);
+        }
+        if (addr <= 14 && end >= 15) {
+            const v = buffer.readUInt16BE(offset + (14 - addr) * 2);
+            values.powerSetpoint = v === 65535 ? Number.NaN : v;
+        }
+        if (addr <= 15 && end >= 16) {
+            values.powerRamp = buffer.readUInt16BE(offset + (15 - addr) * 2);
+        }
+        if (addr <= 16 && end >= 17) {
+            values.powerSlewUp = buffer.readUInt16BE(offset + (16 - addr) * 2);
+        }
+        if (addr <= 17 && end >= 18) {
+            values.powerSlewDown = buffer.readUInt16BE(offset + (17 - addr) * 2);
+        }
+        if (addr <= 18 && end >= 19) {
+            values.sampleDivider = buffer.readUInt16BE(offset + (18 - addr) * 2);
+        }
+        if (addr <= 19 && end >= 20) {
+            values.sampleFifo = buffer.readUInt16BE(offset + (19 - addr) * 2);
+        }
+        if (addr <= 20 && end >= 21) {
+            values.sampleLost = buffer.readUInt16BE(offset + (20 - addr) * 2);
+        }
+        if (addr <= 21 && end >= 22) {
+            values.reportInterval = buffer.readUInt16BE(offset + (21 - addr) * 2);
+        }
+        if (addr <= 22 && end >= 23) {
+            values.reportPowerDeadband = buffer.readUInt16BE(offset + (22 - addr) * 2);
+        }
+        if (addr <= 23 && end >= 24) {
+            values.reportTempDeadband = buffer.readUInt16BE(offset + (23 - addr) * 2) / 100;
+        }
+        if (addr <= 24 && end >= 26) {
+            values.uptime = buffer.readUInt32BE(offset + (24 - addr) * 2);
+        }
+        if (addr <= 26 && end >= 27) {
+            values.adcAt = buffer.readUInt16BE(offset + (26 - addr) * 2);
+        }
+        if (addr <= 27 && end >= 28) {
+            values.pt1000At = buffer.readUInt16BE(offset + (27 - addr) * 2);
+        }
+        if (addr <= 28 && end >= 29) {
+            values.sensor0PulseAt = buffer.readUInt16BE(offset + (28 - addr) * 2);
+        }
+        if (addr <= 29 && end >= 30) {
+            values.uart1Bitrate = buffer.readUInt16BE(offset + (29 - addr) * 2);
+        }
+        if (addr <= 30 && end >= 31) {
+            values.overcurrentTrip = buffer.readUInt16BE(offset + (30 - addr) * 2) / 2048;
+        }
+        if (addr <= 31 && end >= 32) {
+            values.fault = buffer.readUInt16BE(offset + (31 - addr) * 2);
+        }
+    }
+
+}
@@ -2,6 +2,7 @@
 export abstract class ModbusFrame  {
 
     public abstract get createdAt (): Date;
+    public abstract get frame (): string | Buffer;
     public abstract get buffer(): Buffer;
     public abstract get ok (): boolean;
     public abstract get checkSumOk (): boolean;
@@ -2,12 +2,13 @@
 import * as debugsx from 'debug-sx';
 const debug: debugsx.ISimpleLogger = debugsx.createSimpleLogger('modbus:ModbusRequest');
 
+import { ModbusFrame } from './modbus-frame';
 import { ModbusAsciiFrame } from './modbus-ascii-frame';
 
 export class ModbusRequest {
     protected _request: ModbusAsciiFrame;
-    protected _requestReceived: ModbusAsciiFrame;
-    protected _response: ModbusAsciiFrame;
+    protected _requestReceived: ModbusFrame;
+    protected _response: ModbusFrame;
     protected _sentAt: Date;
     protected _requestReceivedAt: Date;
     protected _responseAt: Date;
@@ -21,11 +22,11 @@ export class ModbusRequest {
         return this._request;
     }
 
-    public get requestReceived (): ModbusAsciiFrame {
+    public get requestReceived (): ModbusFrame {
         return this._requestReceived;
     }
 
-    public set requestReceived (value: ModbusAsciiFrame) {
+    public set requestReceived (value: ModbusFrame) {
         if (this._requestReceived) { throw new Error('_requestReceived already set'); }
         if (!this._request.buffer || !value.buffer) { throw new Error('cannot set requestReceived, internal error'); }
         if (this._request.buffer.length !== value.buffer.length) {
@@ -40,11 +41,11 @@ export class ModbusRequest {
         this._requestReceivedAt = new Date();
     }
 
-    public get response (): ModbusAsciiFrame {
+    public get response (): ModbusFrame {
         return this._response;
     }
 
-    public set response (value: ModbusAsciiFrame) {
+    public set response (value: ModbusFrame) {
         if (this._error || this._response) { throw new Error('response/error already set'); }
         if (!this._requestReceived) { throw new Error('requestReceived not set before'); }
         this._response = value;
@@ -85,7 +86,7 @@ export class ModbusRequestFactory extends ModbusRequest {
     public static createReadHoldRegister (dev: number, addr: number, quantity: number): ModbusRequestFactory {
         if (dev < 0 || dev > 255) { throw new Error('illegal arguments'); }
         if (addr < 1 || addr >= 0x10000) { throw new Error('illegal arguments'); }
-        if (quantity < 1 || quantity >= 0x7d) { throw new Error('illegal arguments'); }
+        if (quantity < 1 || quantity > 0x7d) { throw new Error('illegal arguments'); }
         const b = Buffer.alloc(6);
         b[0] = dev;
         b[1] = 0x03;
@@ -138,6 +139,51 @@ export class ModbusRequestFactory extends ModbusRequest {
         return new ModbusRequestFactory(new ModbusAsciiFrame(b));
     }
 
+    public static createReadWriteMultipleHoldRegisters (dev: number, readAddr: number, readQuantity: number,
+                                                        writeAddr: number, values: number []): ModbusRequestFactory {
+        if (dev < 0 || dev > 255) { throw new Error('illegal arguments'); }
+        if (readAddr < 1 || readAddr >= 0x10000) { throw new Error('illegal arguments'); }
+        if (readQuantity < 1 || readQuantity > 0x7d) { throw new Error('illegal arguments'); }
+        if (writeAddr < 1 || writeAddr >= 0x10000) { throw new Error('illegal arguments'); }
+        if (!Array.isArray(values) || values.length < 1 || values.length > 0x79) { throw new Error('illegal arguments'); }
+        const writeQuantity = values.length;
+        const b = Buffer.alloc(11 + writeQuantity * 2);
+        b[0] = dev;
+        b[1] = 0x17;
+        /* tslint:disable:no-bitwise */
+        b[2] = (readAddr - 1) >> 8;
+        b[3] = (readAddr - 1) & 0xff;
+        b[4] = readQuantity >> 8;
+        b[5] = readQuantity & 0xff;
+        b[6] = (writeAddr - 1) >> 8;
+        b[7] = (writeAddr - 1) & 0xff;
+        b[8] = writeQuantity >> 8;
+        b[9] = writeQuantity & 0xff;
+        b[10] = writeQuantity * 2;
+        for (let i = 0; i < writeQuantity; i++) {
+            const v = values[i];
+            if (v < 0 || v > 0xffff) { throw new Error('illegal arguments'); }
+            b[11 + i * 2] = v >> 8;
+            b[12 + i * 2] = v & 0xff;
+        }
+        /* tslint:enable:no-bitwise */
+        return new ModbusRequestFactory(new ModbusAsciiFrame(b));
+    }
+
+    // addr: FIFO pointer address, response contains byte count (2 bytes), FIFO count (2 bytes) and max. 31 registers
+    public static createReadFifoQueue (dev: number, addr: number): ModbusRequestFactory {
+        if (dev < 0 || dev > 255) { throw new Error('illegal arguments'); }
+        if (addr < 1 || addr >= 0x10000) { throw new Error('illegal arguments'); }
+        const b = Buffer.alloc(4);
+        b[0] = dev;
+        b[1] = 0x18;
+        /* tslint:disable:no-bitwise */
+        b[2] = (addr - 1) >> 8;
+        b[3] = (addr - 1) & 0xff;
+        /* tslint:enable:no-bitwise */
+        return new ModbusRequestFactory(new ModbusAsciiFrame(b));
+    }
+
     private _isLogSetRegister: boolean;
 
     constructor (request: ModbusAsciiFrame) {
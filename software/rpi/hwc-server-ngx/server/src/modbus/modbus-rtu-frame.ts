@@ -0,0 +1,105 @@
+
+import * as debugsx from 'debug-sx';
+const debug: debugsx.ISimpleLogger = debugsx.createSimpleLogger('modbus:ModbusRtuFrame');
+
+import { ModbusFrame } from './modbus-frame';
+
+
+export class ModbusRtuFrame implements ModbusFrame {
+
+    public static crc16 (b: Buffer, length: number): number {
+        let crc = 0xffff;
+        for (let i = 0; i < length; i++) {
+            /* tslint:disable:no-bitwise */
+            crc ^= b[i];
+            for (let j = 0; j < 8; j++) {
+                crc = (crc & 1) ? (crc >>> 1) ^ 0xa001 : (crc >>> 1);
+            }
+            /* tslint:enable:no-bitwise */
+        }
+        return crc;
+    }
+
+    private _createdAt: Date;
+    private _frame?: Buffer;
+    private _buffer?: Buffer;
+    private _crcOk: boolean;
+    private _error: Error;
+
+    // x: frame without CRC (toSend = true) or received frame including CRC
+    public constructor (x: Buffer, toSend = true) {
+        this._createdAt = new Date();
+        try {
+            if (x && x instanceof Buffer && toSend && x.length >= 2) {
+                this._buffer = x;
+                const crc = ModbusRtuFrame.crc16(x, x.length);
+                this._frame = Buffer.alloc(x.length + 2);
+                x.copy(this._frame);
+                /* tslint:disable:no-bitwise */
+                this._frame[x.length] = crc & 0xff;
+                this._frame[x.length + 1] = crc >> 8;
+                /* tslint:enable:no-bitwise */
+                this._crcOk = true;
+
+            } else if (x && x instanceof Buffer && !toSend && x.length >= 4) {
+                this._frame = x;
+                this._buffer = x.slice(0, x.length - 2);
+                this._crcOk = ModbusRtuFrame.crc16(x, x.length) === 0;
+
+            } else {
+                throw new Error('cannot create frame from ' + (x ? x.toString('hex') : x));
+            }
+        } catch (err) {
+            this._error = err;
+        }
+    }
+
+    public get createdAt (): Date {
+        return this._createdAt;
+    }
+
+    public get frame (): Buffer {
+        return this._frame;
+    }
+
+    public get buffer(): Buffer {
+        return this._buffer;
+    }
+
+    public get checkSumOk (): boolean {
+        return this._crcOk;
+    }
+
+    public get ok (): boolean {
+        return this._error === undefined;
+    }
+
+    public get crcOk (): boolean {
+        return this._crcOk;
+    }
+
+    public get address (): number {
+        return this._buffer[0];
+    }
+
+    public get funcCode (): number {
+        return this._buffer[1];
+    }
+
+    public get excCode (): number {
+        if (this.funcCode < 128) {
+            return Number.NaN;
+        } else {
+            return this._buffer[2];
+        }
+    }
+
+    public byteAt (index: number): number {
+        return this._buffer[index];
+    }
+
+    public wordAt (index: number): number {
+        return this._buffer[index] * 256 + this._buffer[index + 1];
+    }
+
+}
@@ -4,7 +4,8 @@ const debug: debugsx.IFullLogger = debugsx.createFullLogger('modbus:ModbusSerial
 
 
 import { ModbusDevice, IModbusDeviceConfig } from './modbus-device';
-import { ModbusSerial } from './modbus-serial';
+import { ModbusSerial, ModbusSerialProtocol } from './modbus-serial';
+import { ModbusFrame } from './modbus-frame';
 
 export interface IModbusSerialDeviceResetConfig {
     disabled?: boolean;
@@ -38,4 +39,24 @@ export abstract class ModbusSerialDevice extends ModbusDevice {
         return this._serial;
     }
 
+    public get protocol (): ModbusSerialProtocol {
+        return this.isModbusRtuDevice ? 'rtu' : 'ascii';
+    }
+
+    // protocol address (0-based) of the holding register for the baud rate negotiation (value = baud rate / 100)
+    // undefined if the baud rate of the device is fixed
+    public get baudRateRegister (): number {
+        return undefined;
+    }
+
+    // called by ModbusSerial after a reset of the targets and the baud rate negotiation,
+    // the device has lost its runtime configuration
+    public async handleTargetReset () {
+    }
+
+    // called by ModbusSerial on unsolicited report frames (function code ModbusSerial.reportFuncCode)
+    public handleReport (f: ModbusFrame) {
+        debug.warn('unexpected report from device %s, ignored', this.name);
+    }
+
 }
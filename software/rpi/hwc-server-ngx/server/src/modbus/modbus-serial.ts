@@ -7,19 +7,27 @@ export interface IModbusSerialConfig {
     disabled?: boolean;
     device:  string;
     options: SerialPort.OpenOptions;
+    highBaudRate?: number;  // negotiated with the device at open() (point-to-point link only), options.baudRate is fallback
 }
 
 import * as SerialPort from 'serialport';
 import { sprintf } from 'sprintf-js';
 import * as nconf from 'nconf';
+import { ModbusFrame } from './modbus-frame';
 import { ModbusAsciiFrame } from './modbus-ascii-frame';
+import { ModbusRtuFrame } from './modbus-rtu-frame';
 import { ModbusRequestFactory, ModbusRequest, ModbusRequestError } from './modbus-request';
 import { IModbusSerialDeviceConfig, ModbusSerialDevice } from './modbus-serial-device';
 import { Gpio } from './gpio';
 
 
+export type ModbusSerialProtocol = 'ascii' | 'rtu';
+
 export class ModbusSerial {
 
+    // unsolicited change of value report from firmware (user defined function code)
+    public static readonly reportFuncCode = 0x41;
+
     private _config: IModbusSerialConfig;
     private _devices: ModbusSerialDevice [];
     private _serialPort: SerialPort;
@@ -27,8 +35,10 @@ export class ModbusSerial {
     private _receive: { frames: boolean, chars: boolean } = { frames: false, chars: false };
     private _openPromise: { resolve: () => void, reject: (err: Error) => void};
     private _frame: string;
+    private _rtuFrame: Buffer;
     private _receivedChars: string;
     private _pending: IPendingRequest [] = [];
+    private _lastProtocol: ModbusSerialProtocol;
     private _errCnt = 0;
 
     public constructor (config?: IModbusSerialConfig) {
@@ -72,11 +82,16 @@ export class ModbusSerial {
                     debug.info('serial port ' + this._config.device + ' opened (' + JSON.stringify(o) + ')');
                     this._devices = devices || [];
                     this.resetTargets(true).then( () => {
-                        this._openPromise.resolve();
+                        return this.waitUntilIdle();
+                    }).then( () => {
+                        const p = this._openPromise;
                         this._openPromise = null;
+                        return this.negotiateBaudRate().then( () => p.resolve() );
                     }).catch ( (err2) => {
-                        this._openPromise.reject(err2);
-                        this._openPromise = null;
+                        if (this._openPromise) {
+                            this._openPromise.reject(err2);
+                            this._openPromise = null;
+                        }
                     });
                 }
             });
@@ -100,7 +115,7 @@ export class ModbusSerial {
         }
     }
 
-    public async send (request: ModbusRequestFactory, timeoutMillis: number): Promise<ModbusRequest> {
+    public async send (request: ModbusRequestFactory, timeoutMillis: number, protocol?: ModbusSerialProtocol): Promise<ModbusRequest> {
         debug.finer('send request, timeoutMillis=%s', timeoutMillis);
         if (!this._serialPort || this._openPromise) { throw new Error('serialPort not open'); }
         if (this._lockedBy) { throw new Error('serial port locked by ' + this._lockedBy); }
@@ -108,6 +123,7 @@ export class ModbusSerial {
         return new Promise<ModbusRequest>( (res, rej) => {
             const x: IPendingRequest = {
                 requ: request,
+                protocol: protocol || 'ascii',
                 timer: null,
                 timerModbus: null,
                 resolve: <any>res,
@@ -118,13 +134,63 @@ export class ModbusSerial {
                 thiz.handleTimeout(x, false);
             }, timeoutMillis);
             this._pending.push(x);
+            this._lastProtocol = x.protocol;
             if (this._pending.length === 1) {
                 this.execute(this._pending[0]);
             }
         });
     }
 
+    // the device switches to its new baud rate after the response to the write request and falls back
+    // to the default rate if no valid frame is received within one second
+    private async negotiateBaudRate () {
+        const baudRate = this._config.highBaudRate;
+        if (!baudRate || baudRate === this._config.options.baudRate) {
+            return;
+        }
+        const d = this._devices.length === 1 ? this._devices[0] : null;
+        if (!d || !(d.baudRateRegister >= 0)) {
+            debug.warn('baud rate %d needs exactly one device supporting it -> keep %d', baudRate, this._config.options.baudRate);
+            return;
+        }
+        const addr = d.baudRateRegister + 1;
+        const value = Math.round(baudRate / 100);
+        try {
+            await this.send(ModbusRequestFactory.createWriteHoldRegister(d.config.slaveAddress, addr, value), d.config.timeoutMillis, d.protocol);
+            await this.updateBaudRate(baudRate);
+            const mr = await this.send(ModbusRequestFactory.createReadHoldRegister(d.config.slaveAddress, addr, 1),
+                                       d.config.timeoutMillis, d.protocol);
+            if (mr.response.buffer.readUInt16BE(3) !== value) {
+                throw new Error('unexpected baud rate ' + mr.response.buffer.readUInt16BE(3) * 100);
+            }
+            debug.info('baud rate %d confirmed by target %s', baudRate, d.name);
+        } catch (err) {
+            debug.warn('baud rate negotiation fails, keep %d\n%e', this._config.options.baudRate, err);
+            if (this._serialPort.baudRate !== this._config.options.baudRate) {
+                await this.updateBaudRate(this._config.options.baudRate);
+                await Gpio.delayMillis(1500); // device falls back after 1s
+            }
+        }
+    }
+
+    private async updateBaudRate (baudRate: number) {
+        await new Promise<void>( (res, rej) => {
+            this._serialPort.update({ baudRate: baudRate }, (err) => err ? rej(err) : res() );
+        });
+        debug.info('serial port %s: baud rate %d', this._config.device, baudRate);
+    }
+
+    // waits until pending resets are done
+    private async waitUntilIdle () {
+        for (let i = 0; i < 200 && (this._lockedBy || this._pending.length > 0); i++) {
+            await Gpio.delayMillis(100);
+        }
+    }
+
     private async resetTargets (isOnStart?: boolean) {
+        if (this._serialPort.baudRate !== this._config.options.baudRate) {
+            await this.updateBaudRate(this._config.options.baudRate); // reset or fallback of device
+        }
         if (this._devices.length === 0) {
             debug.info('no devices known -> skip resetTargets');
             return;
@@ -179,6 +245,9 @@ export class ModbusSerial {
                 proms.push(p);
             }
         }
+        if (proms.length === 0) {
+            this._lockedBy = null;
+        }
     }
 
     private async resetTarget(req: IPendingRequest) {
@@ -326,6 +395,13 @@ export class ModbusSerial {
             process.nextTick( () => {
                 this.resetTargets(false).then( () => {
                     debug.info('resetTargets() done successfully');
+                    return this.waitUntilIdle();
+                }).then( () => {
+                    return this.negotiateBaudRate();
+                }).then( async () => {
+                    for (const d of this._devices) {
+                        await d.handleTargetReset();
+                    }
                 }).catch( (er) => {
                     debug.warn(new ModbusSerialError('resetTargets() fails', err));
                 });
@@ -368,7 +444,9 @@ export class ModbusSerial {
                 return;
             }
             const requ = <ModbusRequest>r.requ;
-            this._serialPort.write(r.requ.request.frame, (err) => {
+            const frame = r.protocol === 'rtu' ? new ModbusRtuFrame(requ.request.buffer).frame : requ.request.frame;
+            this._rtuFrame = null;
+            this._serialPort.write(frame, (err) => {
                 if (err) {
                     this.handleError(r, new ModbusRequestError('serial interface error', err));
                 } else {
@@ -408,8 +486,12 @@ export class ModbusSerial {
             return;
         }
 
-        if (this._pending.length === 0) {
+        // reports can arrive without pending request, framing is taken from last request
+        const protocol = this._pending.length > 0 ? this._pending[0].protocol : this._lastProtocol;
+        if (this._pending.length === 0 && !protocol) {
             debug.warn('unexpected bytes (no request pending) received (%o)', data);
+        } else if (protocol === 'rtu') {
+            this.handleRtuData(data);
         } else {
             for (const b of data) {
                 const c = String.fromCharCode(b);
@@ -428,50 +510,142 @@ export class ModbusSerial {
                     let f: ModbusAsciiFrame;
                     let err: any;
                     try {  f = new ModbusAsciiFrame(this._frame); } catch (e) { err = err; }
-                    this._frame = null;
                     if (!err && !f.lrcOk) {
                         debug.warn('LRC/CRC error on request (%s)', this._frame);
                     }
-                    const r = this._pending[0];
-                    if (!(r.requ instanceof ModbusRequest)) {
-                        this.handleError(r, new Error('receive Modbus frame, but no modbus request pending'));
+                    this._frame = null;
+                    if (f && f.ok && f.funcCode === ModbusSerial.reportFuncCode) {
+                        this.handleReport(f);
+                    } else if (this._pending.length === 0) {
+                        debug.warn('unexpected frame (no request pending) received (%o)', f);
+                    } else if (this.handleFrame(f, err)) {
                         return;
                     }
-                    const requ = <ModbusRequest>r.requ;
-                    if (this._errCnt > 5) {
-                        debug.info('modbus serial seems to work now');
-                    }
-                    this._errCnt = 0;
-                    if (f) {
-                        if (!requ.requestReceivedAt) {
-                            try {
-                                requ.requestReceived = f;
-                                debug.finer('receive request (LRC %s) %o', f.lrcOk ? 'OK' : 'ERROR', f);
-                            } catch (e) {
-                                if (err) {
-                                    debug.warn(err);
-                                }
-                                debug.warn('waiting for request, but receiving invalid frame\n%o\n%e', f, e);
-                            }
-                        } else {
-                            requ.response = f;
-                            debug.finer('receive response (LRC %s) %o', f.lrcOk ? 'OK' : 'ERROR', f);
-                        }
-                    }
+                }
+            }
+        }
+    }
 
-                    if (err || requ.response) {
-                        debug.finer('handleOnSerialData(): removing pending request -> length =%s', this._pending.length);
-                        if (err) {
-                            const message = err && err.message ? ' (' + err.message + ')' : '';
-                            r.requ.error = new ModbusRequestError('Modbus request fails' + message, requ, err);
-                            this.handleError(r, err);
-                        } else  {
-                            this.handleSuccess(r, requ);
-                        }
+    private handleRtuData (data: Buffer) {
+        // Modbus RTU frames are not delimited, frame length is given by request and function code
+        this._rtuFrame = this._rtuFrame ? Buffer.concat([ this._rtuFrame, data ]) : data;
+        while (this._rtuFrame) {
+            const isReport = this._rtuFrame.length >= 2 && this._rtuFrame[1] === ModbusSerial.reportFuncCode;
+            if (!isReport && this._pending.length === 0) {
+                debug.warn('unexpected bytes (no request pending) received (%o)', this._rtuFrame);
+                this._rtuFrame = null;
+                return;
+            }
+            let length: number;
+            if (isReport) {
+                length = this._rtuFrame.length < 3 ? 0 : 5 + this._rtuFrame[2];
+            } else {
+                length = this.expectedRtuFrameLength(<ModbusRequest>this._pending[0].requ, this._rtuFrame);
+            }
+            if (!(length > 0) || this._rtuFrame.length < length) {
+                return;
+            }
+            if (debug.finest.enabled) {
+                debug.finest('receive Modbus RTU frame %s bytes', length);
+            }
+            const f = new ModbusRtuFrame(this._rtuFrame.slice(0, length), false);
+            this._rtuFrame = this._rtuFrame.length > length ? this._rtuFrame.slice(length) : null;
+            if (!f.crcOk) {
+                debug.warn('LRC/CRC error on request (%s)', f.frame.toString('hex'));
+            }
+            if (isReport) {
+                if (f.ok) {
+                    this.handleReport(f);
+                }
+                continue;
+            }
+            if (this.handleFrame(f, f.ok ? undefined : new Error('invalid Modbus RTU frame'))) {
+                return;
+            }
+        }
+    }
+
+    private expectedRtuFrameLength (requ: ModbusRequest, b: Buffer): number {
+        if (!(requ instanceof ModbusRequest)) {
+            return -1;
+        } else if (!requ.requestReceivedAt) {
+            return requ.request.buffer.length + 2; // echo of request
+        } else if (b.length < 3) {
+            return 0;
+        }
+        /* tslint:disable-next-line:no-bitwise */
+        if (b[1] & 0x80) {
+            return 5;
+        }
+        switch (b[1]) {
+            case 0x03: case 0x04: case 0x17: return 5 + b[2];
+            case 0x05: case 0x06: case 0x0f: case 0x10: return 8;
+            /* tslint:disable-next-line:no-bitwise */
+            case 0x18: return b.length < 4 ? 0 : 6 + (b[2] << 8 | b[3]);
+            default: {
+                debug.warn('unsupported function code %s in Modbus RTU frame', b[1]);
+                return b.length;
+            }
+        }
+    }
+
+    private handleReport (f: ModbusFrame) {
+        if (!f.checkSumOk) {
+            debug.warn('LRC/CRC error on report, ignored (%o)', f.frame);
+            return;
+        }
+        const d = this._devices && this._devices.find( (item) => item.config.slaveAddress === f.address);
+        if (!d) {
+            debug.warn('report from unknown slave address %d, ignored', f.address);
+            return;
+        }
+        try {
+            d.handleReport(f);
+        } catch (err) {
+            debug.warn('handling report fails\n%e', err);
+        }
+    }
+
+    // returns true if processing of received bytes must be stopped
+    private handleFrame (f: ModbusFrame, err: any): boolean {
+        const r = this._pending[0];
+        if (!(r.requ instanceof ModbusRequest)) {
+            this.handleError(r, new Error('receive Modbus frame, but no modbus request pending'));
+            return true;
+        }
+        const requ = <ModbusRequest>r.requ;
+        if (this._errCnt > 5) {
+            debug.info('modbus serial seems to work now');
+        }
+        this._errCnt = 0;
+        if (f) {
+            if (!requ.requestReceivedAt) {
+                try {
+                    requ.requestReceived = f;
+                    debug.finer('receive request (LRC %s) %o', f.checkSumOk ? 'OK' : 'ERROR', f);
+                } catch (e) {
+                    if (err) {
+                        debug.warn(err);
                     }
+                    debug.warn('waiting for request, but receiving invalid frame\n%o\n%e', f, e);
                 }
+            } else {
+                requ.response = f;
+                debug.finer('receive response (LRC %s) %o', f.checkSumOk ? 'OK' : 'ERROR', f);
+            }
+        }
+
+        if (err || requ.response) {
+            debug.finer('handleOnSerialData(): removing pending request -> length =%s', this._pending.length);
+            if (err) {
+                const message = err && err.message ? ' (' + err.message + ')' : '';
+                r.requ.error = new ModbusRequestError('Modbus request fails' + message, requ, err);
+                this.handleError(r, err);
+            } else  {
+                this.handleSuccess(r, requ);
             }
         }
+        return false;
     }
 
 }
@@ -484,6 +658,7 @@ interface IResetRequest {
 
 interface IPendingRequest {
     requ?: ModbusRequestFactory | IResetRequest;
+    protocol?: ModbusSerialProtocol;
     timer: NodeJS.Timer;
     timerModbus: NodeJS.Timer;
     resolve: (requ: IResetRequest | ModbusRequest) => void;
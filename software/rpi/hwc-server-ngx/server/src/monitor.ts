@@ -48,10 +48,6 @@ export class Monitor {
 
     private static _instance: Monitor;
 
-    private static powerTable: { [ current: number ]: number } = {
-        6: 2.8, 7: 5.7, 8: 26, 9: 48, 10: 122, 11: 257, 12: 460, 13: 716, 14: 1045, 15: 1292, 16: 1553, 17: 1730, 18: 1870, 19: 1935, 20: 1950
-    };
-
 
     // ***************************************************************
 
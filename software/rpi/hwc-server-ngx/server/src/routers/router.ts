@@ -40,6 +40,7 @@ export class Router {
         this._router.get('/server/about', (req, res, next) => this.getServerAbout(req, res, next));
         this._router.get('/monitor', (req, res, next) => this.getMonitor(req, res, next));
         this._router.post('/controller/parameter', (req, res, next) => this.postControllerParameter(req, res, next));
+        this._router.get('/controller/tasktimes', (req, res, next) => this.getControllerTaskTimes(req, res, next));
     }
 
     private async getServerAbout (req: express.Request, res: express.Response, next: express.NextFunction) {
@@ -140,6 +141,19 @@ export class Router {
     //     }
     // }
 
+    private async getControllerTaskTimes (req: express.Request, res: express.Response, next: express.NextFunction) {
+        try {
+            const hwc = HotWaterController.getInstance();
+            const rv = await hwc.readTaskTimes();
+            if (req.query && req.query.clear !== undefined) {
+                await hwc.clearTaskTimes();
+            }
+            res.json(rv);
+        } catch (err) {
+            handleError(err, req, res, next, debug);
+        }
+    }
+
     private async postControllerParameter (req: express.Request, res: express.Response, next: express.NextFunction) {
         try {
             const c = Controller.getInstance();